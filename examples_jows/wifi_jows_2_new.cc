@@ -38,147 +38,3550 @@
 #include <ns3/constant-position-mobility-model.h>
 #include <ns3/hybrid-buildings-propagation-loss-model.h>
 
+//for worker processes used by replications
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <cxxabi.h>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "wifi_jows_frozen_mobility.h"
+#include "wifi_jows_loss_cache.h"
+#include "wifi_jows_grid_channel.h"
+#include "wifi_jows_profiler.h"
+
 using namespace ns3; 
 
 NS_LOG_COMPONENT_DEFINE ("wifi-qos-test");
 
-class SimulationHelper 
+//attribute changes applied to one copy of a run forked at the branch time (see ForkVariants)
+struct VariantSpec
+{
+  std::string name;
+  std::vector<std::pair<std::string, std::string> > changes; //Mac-relative attribute path, cbsa<TID> or TID name -> value
+};
+
+//scenario configuration - filled once from the command line
+struct SimulationParameters
+{
+  uint32_t nSTA;
+  uint32_t packetSize;
+  float simTime;
+  Time appsStart;
+  float radius;
+  float calcStart;
+  bool oneDest;
+  bool rtsCts;
+  bool A_VO;
+  bool VO;
+  bool VI;
+  bool A_VI;
+  bool BE;
+  bool BK;
+  double Mbps;
+  uint32_t seed;
+  bool flowMonitor;
+  std::string resultsFile;
+  bool configPaths;
+  bool fast;
+  bool perfReport;
+  bool macSource;
+  uint32_t macSourceDepth;
+  bool backpressure;
+  uint32_t backpressureThreshold;
+  double samplePeriod;
+  double ciTarget;
+  bool gridChannel;
+  bool lossCache;
+  bool staticNodes;
+  uint32_t profile;           //top-N callback targets of the event profiler (0 - off)
+  std::string eventTrace;     //binary packet event trace file (empty - off)
+  uint32_t eventTraceRecords; //ring capacity
+  std::string pcapFile;       //sampled pcap capture (empty - off)
+  std::string pcapSample;     //1 in N frames: N, TID:N, ctl:N
+  uint32_t pcapSnapLen;       //0 - MAC, LLC, IP and UDP headers
+  std::string sampleFile;
+  uint32_t nBss;              //co-located BSSs (0 - single-BSS scenario of nSTA stations)
+  uint32_t staPerBss;         //stations per BSS (0 - nSTA)
+  uint32_t bssChannels;       //channels the BSSs are spread over (0 - all 24 of 802.11a)
+  uint32_t coChannelBss;      //BSSs sharing the channel in this run (set per multi-BSS partition)
+  uint16_t channelNumber;     //0 - default channel of the standard
+  bool queueStats;            //peak and average occupancy of the AltEDCA queues
+  std::string queueSampleFile; //CSV time series of the queue occupancy (empty - off)
+  double branchTime;          //end of the warm-up shared by the variants [s]
+  std::vector<VariantSpec> variants; //continuations forked at branchTime (empty - off; the first one is the unchanged base)
+  uint32_t variantJobs;       //variants run at once
+  std::map<uint8_t, DataRate> cbsaIdleSlope;                          //TID -> CBSA idleSlope (strict priority if not set)
+  std::vector<std::pair<std::string, std::string> > configOverrides; //Mac-relative attribute path -> value
+};
+
+//per-TID results of a single run (plain data - sent back from worker processes as raw bytes)
+struct TidResults
+{
+  uint64_t txBytes;
+  uint64_t rxBytes;
+  uint64_t txPackets;
+  uint64_t rxPackets;
+  uint64_t lostPackets;     //dropped at enqueue, expired (MaxDelay) or failed after the retry limit
+  uint64_t inFlightPackets; //sent but neither received nor lost by the end of the run (still queued or being sent)
+  double   throughput; //[Mb/s]
+  int64_t  delaySum;   //[ns]
+  int64_t  jitterSum;  //[ns]
+  uint64_t offeredPackets; //packets scheduled by backpressure sources, incl. those never generated
+  double   offeredLoad;    //[Mb/s]
+  uint32_t samples;          //time-series samples (0 - sampling off)
+  double   warmup;           //end of the transient detected by MSER-5 [s] (<0 - no steady state detected)
+  double   steadyThroughput; //[Mb/s] after warmup
+  double   steadyDelay;      //[ms] after warmup
+  uint64_t steadyPackets;    //received after warmup
+  double   delayP50;   //[ms] delay percentiles (LatencyHistogram, 0 - nothing received)
+  double   delayP99;   //[ms]
+  double   delayP999;  //[ms]
+};
+
+//saturation throughput and access delay predicted by the analytical EDCA model
+struct AnalyticResults
+{
+  double throughput[8];  //[Mb/s] (IP packets, as counted by TidStatistics)
+  double accessDelay[8]; //[ms] mean service time of the head-of-line frame of one station
+};
+
+//occupancy of one of the six AltEDCA queues over all nodes (queueStats=1)
+struct QueueResults
+{
+  uint32_t peak;       //[packets] largest of all nodes
+  uint32_t peakNode;
+  double meanAverage;  //[packets] time average after calcStart, mean of all nodes
+  double maxAverage;   //[packets] largest time average of a node
+};
+
+struct SimulationResults
+{
+  TidResults tid[8];
+  QueueResults queue[6]; //in the order VO/Hi, VO/Low, VI/Hi, VI/Low, BE, BK
+  bool queueStats;
+  uint64_t queuedPeakPackets; //high-water marks of all queues together (merged partitions: sum of their peaks)
+  uint64_t queuedPeakBytes;
+  uint32_t nodes;       //simulated nodes (weight of a partition in MergeResults)
+  uint32_t partitions;  //multi-BSS partitions merged into these results (0 - single run)
+  double totalDelayP50;  //[ms] delay percentiles of all TIDs together
+  double totalDelayP99;
+  double totalDelayP999;
+  double stopTime;  //actual end of the run [s] (earlier than simTime if ciTarget was reached)
+  bool ciReached;
+};
+
+//tags every data packet leaving the IP layer with its TID, IP size and transmission time
+class TidTimestampTag : public Tag
+{
+public:
+  TidTimestampTag ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+  uint8_t m_tid;
+  uint32_t m_size;   //IP packet size [B] (as counted by FlowMonitor)
+  int64_t m_txTime;  //[ns]
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TidTimestampTag);
+
+TidTimestampTag::TidTimestampTag ()
+  : m_tid (0),
+    m_size (0),
+    m_txTime (0)
+{
+}
+
+TypeId
+TidTimestampTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TidTimestampTag")
+    .SetParent<Tag> ()
+    .AddConstructor<TidTimestampTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+TidTimestampTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+TidTimestampTag::GetSerializedSize (void) const
+{
+  return 1 + 4 + 8;
+}
+
+void
+TidTimestampTag::Serialize (TagBuffer i) const
+{
+  i.WriteU8 (m_tid);
+  i.WriteU32 (m_size);
+  i.WriteU64 (m_txTime);
+}
+
+void
+TidTimestampTag::Deserialize (TagBuffer i)
+{
+  m_tid = i.ReadU8 ();
+  m_size = i.ReadU32 ();
+  m_txTime = i.ReadU64 ();
+}
+
+void
+TidTimestampTag::Print (std::ostream &os) const
+{
+  os << "tid=" << (uint16_t) m_tid << " size=" << m_size << " txTime=" << m_txTime;
+}
+
+//log-bucketed delay histogram (HDR style) with bounded memory (3.5 KB) for percentiles:
+//delays counted in 1 us units, exact below 64 us, above that 32 sub-buckets per power of two (<= 3% error), up to 4295 s
+class LatencyHistogram
+{
+public:
+  static const uint32_t UNIT = 1000;      //[ns]
+  static const uint32_t SUB_BUCKETS = 32;
+  static const uint32_t BUCKETS = 896;    //SUB_BUCKETS * (32 - 5) + SUB_BUCKETS
+
+  LatencyHistogram ();
+
+  void Record (int64_t delay); //[ns]
+  void Add (const LatencyHistogram &other);
+  uint64_t GetCount (void) const;
+  uint32_t GetBucketCount (uint32_t bucket) const;
+  double GetPercentile (double q) const; //[ms]
+
+  static void GetBucketRange (uint32_t bucket, uint64_t &lower, uint64_t &width); //[UNIT]
+
+private:
+  uint32_t m_counts[BUCKETS];
+  uint64_t m_count;
+  int64_t m_max; //[ns]
+};
+
+LatencyHistogram::LatencyHistogram ()
+  : m_count (0),
+    m_max (0)
+{
+  std::memset (m_counts, 0, sizeof (m_counts));
+}
+
+void
+LatencyHistogram::Record (int64_t delay)
+{
+  uint64_t v = (delay > 0) ? delay / UNIT : 0;
+  uint32_t bucket;
+  if (v < 2 * SUB_BUCKETS)
+    bucket = v;
+  else
+    {
+      uint32_t magnitude = 63 - __builtin_clzll (v);  //v in [2^magnitude, 2^(magnitude+1))
+      uint32_t shift = magnitude - 5;                 //v >> shift in [32, 63]
+      bucket = std::min<uint64_t> (SUB_BUCKETS * shift + (v >> shift), BUCKETS - 1);
+    }
+  m_counts[bucket]++;
+  m_count++;
+  m_max = std::max (m_max, delay);
+}
+
+void
+LatencyHistogram::Add (const LatencyHistogram &other)
+{
+  for (uint32_t i = 0; i < BUCKETS; i++)
+    m_counts[i] += other.m_counts[i];
+  m_count += other.m_count;
+  m_max = std::max (m_max, other.m_max);
+}
+
+uint64_t
+LatencyHistogram::GetCount (void) const
+{
+  return m_count;
+}
+
+uint32_t
+LatencyHistogram::GetBucketCount (uint32_t bucket) const
+{
+  return m_counts[bucket];
+}
+
+void
+LatencyHistogram::GetBucketRange (uint32_t bucket, uint64_t &lower, uint64_t &width)
+{
+  if (bucket < 2 * SUB_BUCKETS)
+    {
+      lower = bucket;
+      width = 1;
+      return;
+    }
+  uint32_t shift = bucket / SUB_BUCKETS - 1;
+  lower = (uint64_t) (bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+  width = (uint64_t) 1 << shift;
+}
+
+//middle of the bucket holding the q-th quantile (not above the largest recorded delay)
+double
+LatencyHistogram::GetPercentile (double q) const
+{
+  if (m_count == 0)
+    return 0.0;
+
+  uint64_t rank = std::max<uint64_t> (1, std::ceil (q * m_count));
+  uint64_t seen = 0;
+  uint32_t bucket = 0;
+  for (; bucket < BUCKETS - 1; bucket++)
+    {
+      seen += m_counts[bucket];
+      if (seen >= rank)
+        break;
+    }
+
+  uint64_t lower, width;
+  GetBucketRange (bucket, lower, width);
+  double ns = std::min ((lower + width / 2.0) * UNIT, (double) m_max);
+  return ns / 1000000;
+}
+
+//streaming per-TID statistics - fixed-size accumulators fed by trace sinks (replaces post-run FlowMonitor aggregation)
+//Tx side: Ipv4L3Protocol SendOutgoing (TID taken from the TOS field, as set by CreateOnOffHelper)
+//Rx side: PacketSink Rx
+class TidStatistics
+{
+public:
+  TidStatistics (Time calcStart);
+
+  void ConnectSource (Ptr<Node> node);
+  void ConnectSink (Ptr<Application> sink);
+
+  void ConnectMacSink (Ptr<Node> node, uint16_t protocol);
+  void ConnectLosses (NetDeviceContainer devices);
+
+  void NotifyTx (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+  void NotifyRx (Ptr<const Packet> packet, const Address &from);
+  void NotifyMacTx (uint8_t tid, Ptr<const Packet> packet);
+  void NotifyOffered (uint8_t tid, uint64_t packets, uint32_t size);
+  void NotifyMacRx (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                    const Address &from, const Address &to, NetDevice::PacketType packetType);
+  void NotifyQueueDrop (Ptr<const WifiMacQueueItem> item);
+  void NotifyMacFailure (const WifiMacHeader &header);
+
+  void Fill (SimulationResults &results, Time calcStop) const;
+
+  void TagAll (void);
+  void GetTotals (uint8_t tid, uint64_t &rxBytes, uint64_t &rxPackets, int64_t &delaySum) const;
+
+  const LatencyHistogram &GetLatency (uint8_t tid) const;
+  const LatencyHistogram *GetFlowLatency (Ipv4Address source, uint16_t port) const;
+
+private:
+  void Tag (uint8_t tid, uint32_t size, Ptr<const Packet> packet);
+  void Receive (Ptr<const Packet> packet, uint64_t flow);
+
+  Time m_calcStart;
+
+  uint64_t m_txBytes[8];
+  uint64_t m_rxBytes[8];
+  uint64_t m_txPackets[8];
+  uint64_t m_rxPackets[8];
+  int64_t  m_delaySum[8];  //[ns]
+  int64_t  m_jitterSum[8]; //[ns]
+  uint64_t m_offeredPackets[8];
+  uint64_t m_offeredBytes[8];
+  uint64_t m_lostPackets[8];
+
+  bool m_tagAll;                //tag packets sent before calcStart too (needed by TidSampler)
+  uint64_t m_totalRxBytes[8];   //received since the start of the run, regardless of calcStart
+  uint64_t m_totalRxPackets[8];
+  int64_t  m_totalDelaySum[8];  //[ns]
+
+  LatencyHistogram m_latency[8];
+
+  struct FlowState
+  {
+    FlowState () : received (false), lastDelay (0) {}
+    bool received;
+    int64_t lastDelay;         //[ns] - needed for jitter
+    LatencyHistogram latency;
+  };
+  std::map<uint64_t, FlowState> m_flows; //per source address/port (IP sinks) or MAC address/TID (MAC sinks)
+  std::set<uint32_t> m_macSinks;           //nodes with the MAC-level sink handler registered
+};
+
+TidStatistics::TidStatistics (Time calcStart)
+  : m_calcStart (calcStart),
+    m_tagAll (false)
+{
+  for (uint8_t tid = 0; tid < 8; tid++)
+    {
+      m_txBytes[tid] = 0;
+      m_rxBytes[tid] = 0;
+      m_txPackets[tid] = 0;
+      m_rxPackets[tid] = 0;
+      m_delaySum[tid] = 0;
+      m_jitterSum[tid] = 0;
+      m_offeredPackets[tid] = 0;
+      m_offeredBytes[tid] = 0;
+      m_lostPackets[tid] = 0;
+      m_totalRxBytes[tid] = 0;
+      m_totalRxPackets[tid] = 0;
+      m_totalDelaySum[tid] = 0;
+    }
+}
+
+void
+TidStatistics::ConnectSource (Ptr<Node> node)
+{
+  Ptr<Ipv4L3Protocol> ip = node->GetObject<Ipv4L3Protocol> ();
+  NS_ASSERT (ip != 0);
+  ip->TraceConnectWithoutContext ("SendOutgoing", MakeCallback (&TidStatistics::NotifyTx, this));
+}
+
+void
+TidStatistics::ConnectSink (Ptr<Application> sink)
+{
+  sink->TraceConnectWithoutContext ("Rx", MakeCallback (&TidStatistics::NotifyRx, this));
+}
+
+//MAC-level saturated sources bypass IP - deliver their frames (protocol number of SaturatedMacSource) to the statistics
+void
+TidStatistics::ConnectMacSink (Ptr<Node> node, uint16_t protocol)
+{
+  if (!m_macSinks.insert (node->GetId ()).second)
+    return;
+  node->RegisterProtocolHandler (MakeCallback (&TidStatistics::NotifyMacRx, this), protocol, 0);
+}
+
+void
+TidStatistics::Tag (uint8_t tid, uint32_t size, Ptr<const Packet> packet)
+{
+  bool counted = (Simulator::Now () >= m_calcStart);
+  if (!counted && !m_tagAll)
+    return;
+
+  TidTimestampTag tag;
+  tag.m_tid = tid;
+  tag.m_size = size;
+  tag.m_txTime = Simulator::Now ().GetNanoSeconds ();
+  packet->AddPacketTag (tag);
+
+  if (!counted)
+    return;
+
+  m_txBytes[tid] += size;
+  m_txPackets[tid]++;
+}
+
+void
+TidStatistics::NotifyTx (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  Tag (header.GetTos () >> 5, packet->GetSize () + header.GetSerializedSize (), packet);
+}
+
+void
+TidStatistics::NotifyMacTx (uint8_t tid, Ptr<const Packet> packet)
+{
+  Tag (tid, packet->GetSize (), packet);
+}
+
+void
+TidStatistics::NotifyRx (Ptr<const Packet> packet, const Address &from)
+{
+  InetSocketAddress source = InetSocketAddress::ConvertFrom (from);
+  Receive (packet, ((uint64_t) source.GetIpv4 ().Get () << 16) | source.GetPort ());
+}
+
+void
+TidStatistics::NotifyMacRx (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                            const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  uint8_t mac[6];
+  Mac48Address::ConvertFrom (from).CopyTo (mac);
+  uint64_t flow = 0;
+  for (uint8_t i = 0; i < 6; i++)
+    flow = (flow << 8) | mac[i];
+
+  TidTimestampTag tag;
+  if (packet->PeekPacketTag (tag))
+    flow = (flow << 8) | tag.m_tid; //one flow per TID of each source
+  Receive (packet, flow);
+}
+
+//packets tagged after calcStart only - the same set as the Tx counters
+void
+TidStatistics::NotifyQueueDrop (Ptr<const WifiMacQueueItem> item)
+{
+  TidTimestampTag tag;
+  if (item->GetPacket ()->PeekPacketTag (tag) && (tag.m_txTime >= m_calcStart.GetNanoSeconds ()))
+    m_lostPackets[tag.m_tid]++;
+}
+
+//the header is all the MAC reports of a frame given up after the retry limit - counted from calcStart on, so a frame
+//sent just before calcStart may be counted too
+void
+TidStatistics::NotifyMacFailure (const WifiMacHeader &header)
+{
+  if (header.IsQosData () && (Simulator::Now () >= m_calcStart))
+    m_lostPackets[header.GetQosTid ()]++;
+}
+
+//offered load of sources that skip packets while their queue is full (see BackpressureSource)
+void
+TidStatistics::NotifyOffered (uint8_t tid, uint64_t packets, uint32_t size)
+{
+  if (Simulator::Now () < m_calcStart)
+    return;
+  m_offeredPackets[tid] += packets;
+  m_offeredBytes[tid] += packets * size;
+}
+
+void
+TidStatistics::Receive (Ptr<const Packet> packet, uint64_t flow)
+{
+  TidTimestampTag tag;
+  if (!packet->PeekPacketTag (tag)) //sent before calcStart
+    return;
+
+  int64_t delay = Simulator::Now ().GetNanoSeconds () - tag.m_txTime;
+
+  m_totalRxBytes[tag.m_tid] += tag.m_size;
+  m_totalRxPackets[tag.m_tid]++;
+  m_totalDelaySum[tag.m_tid] += delay;
+  if (tag.m_txTime < m_calcStart.GetNanoSeconds ()) //tagged for TidSampler only
+    return;
+
+  m_rxBytes[tag.m_tid] += tag.m_size;
+  m_rxPackets[tag.m_tid]++;
+  m_delaySum[tag.m_tid] += delay;
+  m_latency[tag.m_tid].Record (delay);
+
+  FlowState &state = m_flows[flow];
+  if (state.received)
+    m_jitterSum[tag.m_tid] += std::abs (delay - state.lastDelay);
+  state.received = true;
+  state.lastDelay = delay;
+  state.latency.Record (delay);
+}
+
+//packets neither received nor lost by the end of the run are reported as in flight, not as lost
+void
+TidStatistics::Fill (SimulationResults &results, Time calcStop) const
+{
+  for (uint8_t tid = 0; tid < 8; tid++)
+    {
+      TidResults &r = results.tid[tid];
+      r.txBytes     = m_txBytes[tid];
+      r.rxBytes     = m_rxBytes[tid];
+      r.txPackets   = m_txPackets[tid];
+      r.rxPackets   = m_rxPackets[tid];
+      r.lostPackets = std::min (m_lostPackets[tid], m_txPackets[tid] - m_rxPackets[tid]);
+      r.inFlightPackets = m_txPackets[tid] - m_rxPackets[tid] - r.lostPackets;
+      r.throughput  = m_rxBytes[tid] * 8.0 / (calcStop - m_calcStart).GetMicroSeconds ();
+      r.delaySum    = m_delaySum[tid];
+      r.jitterSum   = m_jitterSum[tid];
+      r.offeredPackets = m_offeredPackets[tid];
+      r.offeredLoad = m_offeredBytes[tid] * 8.0 / (calcStop - m_calcStart).GetMicroSeconds ();
+      r.delayP50    = m_latency[tid].GetPercentile (0.5);
+      r.delayP99    = m_latency[tid].GetPercentile (0.99);
+      r.delayP999   = m_latency[tid].GetPercentile (0.999);
+    }
+
+  LatencyHistogram total;
+  for (uint8_t tid = 0; tid < 8; tid++)
+    total.Add (m_latency[tid]);
+  results.totalDelayP50  = total.GetPercentile (0.5);
+  results.totalDelayP99  = total.GetPercentile (0.99);
+  results.totalDelayP999 = total.GetPercentile (0.999);
+}
+
+void
+TidStatistics::TagAll (void)
+{
+  m_tagAll = true;
+}
+
+void
+TidStatistics::GetTotals (uint8_t tid, uint64_t &rxBytes, uint64_t &rxPackets, int64_t &delaySum) const
+{
+  rxBytes = m_totalRxBytes[tid];
+  rxPackets = m_totalRxPackets[tid];
+  delaySum = m_totalDelaySum[tid];
+}
+
+const LatencyHistogram &
+TidStatistics::GetLatency (uint8_t tid) const
+{
+  return m_latency[tid];
+}
+
+//delays of one UDP flow (0 if nothing received from the source)
+const LatencyHistogram *
+TidStatistics::GetFlowLatency (Ipv4Address source, uint16_t port) const
+{
+  std::map<uint64_t, FlowState>::const_iterator state = m_flows.find (((uint64_t) source.Get () << 16) | port);
+  return (state != m_flows.end ()) ? &state->second.latency : 0;
+}
+
+
+
+/* ===== time series and warm-up detection ===== */
+
+//per-TID throughput and mean delay sampled every period (cf. Experiment::CheckThroughput in wifi-multirate)
+//fixed number of slots - when all are used, neighbouring slots are merged and the period doubled,
+//so memory stays constant and the whole run (including the transient) is kept for MSER-5
+class TidSampler
+{
+public:
+  static const uint32_t SLOTS = 1024;
+
+  TidSampler (TidStatistics *tidStats, Time period);
+
+  void Start (Time start);
+  void SetStopRule (double ciTarget, Time calcStart, uint8_t tidMask);
+  void Fill (SimulationResults &results) const;
+  bool CiReached (void) const;
+  void Write (std::string fileName) const;
+
+private:
+  struct Slot
+  {
+    uint64_t rxBytes;
+    uint64_t rxPackets;
+    int64_t  delaySum; //[ns]
+  };
+
+  void Sample (void);
+  bool CheckPrecision (void) const;
+  static int32_t Mser5 (const std::vector<double> &series);
+
+  TidStatistics *m_tidStats;
+  Time m_start;
+  Time m_period;
+  uint32_t m_count;
+  std::vector<Slot> m_slots; //SLOTS x 8 TIDs
+
+  uint64_t m_lastRxBytes[8];
+  uint64_t m_lastRxPackets[8];
+  int64_t  m_lastDelaySum[8];
+
+  double m_ciTarget;   //relative 95% CI half-width stopping the run (0 - run until simTime)
+  Time m_calcStart;
+  uint8_t m_tidMask;   //TIDs that must reach m_ciTarget
+  bool m_ciReached;
+};
+
+TidSampler::TidSampler (TidStatistics *tidStats, Time period)
+  : m_tidStats (tidStats),
+    m_period (period),
+    m_count (0),
+    m_ciTarget (0),
+    m_tidMask (0),
+    m_ciReached (false)
+{
+  for (uint8_t tid = 0; tid < 8; tid++)
+    {
+      m_lastRxBytes[tid] = 0;
+      m_lastRxPackets[tid] = 0;
+      m_lastDelaySum[tid] = 0;
+    }
+}
+
+//must be called before the traffic starts
+void
+TidSampler::Start (Time start)
+{
+  m_tidStats->TagAll ();
+  m_slots.resize (SLOTS * 8);
+  m_start = start;
+  Simulator::Schedule (start + m_period, &TidSampler::Sample, this);
+}
+
+//stop the simulation as soon as the throughput and mean delay of all TIDs in tidMask are known with the given precision
+void
+TidSampler::SetStopRule (double ciTarget, Time calcStart, uint8_t tidMask)
+{
+  m_ciTarget = ciTarget;
+  m_calcStart = calcStart;
+  m_tidMask = tidMask;
+}
+
+bool
+TidSampler::CiReached (void) const
+{
+  return m_ciReached;
+}
+
+void
+TidSampler::Sample (void)
+{
+  for (uint8_t tid = 0; tid < 8; tid++)
+    {
+      uint64_t rxBytes, rxPackets;
+      int64_t delaySum;
+      m_tidStats->GetTotals (tid, rxBytes, rxPackets, delaySum);
+
+      Slot &slot = m_slots[m_count * 8 + tid];
+      slot.rxBytes = rxBytes - m_lastRxBytes[tid];
+      slot.rxPackets = rxPackets - m_lastRxPackets[tid];
+      slot.delaySum = delaySum - m_lastDelaySum[tid];
+
+      m_lastRxBytes[tid] = rxBytes;
+      m_lastRxPackets[tid] = rxPackets;
+      m_lastDelaySum[tid] = delaySum;
+    }
+  m_count++;
+
+  if (m_count == SLOTS) //all slots used - merge pairs, so all slots keep covering the same period
+    {
+      for (uint32_t i = 0; i < SLOTS / 2; i++)
+        for (uint8_t tid = 0; tid < 8; tid++)
+          {
+            Slot &a = m_slots[(2 * i) * 8 + tid];
+            Slot &b = m_slots[(2 * i + 1) * 8 + tid];
+            Slot &merged = m_slots[i * 8 + tid];
+            merged.rxBytes = a.rxBytes + b.rxBytes;
+            merged.rxPackets = a.rxPackets + b.rxPackets;
+            merged.delaySum = a.delaySum + b.delaySum;
+          }
+      m_count = SLOTS / 2;
+      m_period = m_period * 2;
+    }
+
+  if ((m_ciTarget > 0) && CheckPrecision ())
+    {
+      m_ciReached = true;
+      Simulator::Stop ();
+      return;
+    }
+
+  Simulator::Schedule (m_period, &TidSampler::Sample, this);
+}
+
+//MSER-5 truncation point [samples] - minimizes the squared standard error of the mean of the
+//remaining batch means (batches of 5 samples); -1 if the minimum lies in the second half (no steady state)
+int32_t
+TidSampler::Mser5 (const std::vector<double> &series)
+{
+  uint32_t m = series.size () / 5;
+  if (m < 4)
+    return -1;
+
+  std::vector<double> z (m, 0.0);
+  for (uint32_t j = 0; j < m; j++)
+    {
+      for (uint32_t k = 0; k < 5; k++)
+        z[j] += series[5 * j + k];
+      z[j] /= 5;
+    }
+
+  //suffix sums, from the last batch backwards
+  double sum = 0.0, sumSq = 0.0, best = 0.0;
+  int32_t bestD = -1;
+  for (int32_t d = m - 1; d >= 0; d--)
+    {
+      sum += z[d];
+      sumSq += z[d] * z[d];
+      double n = m - d;
+      double mser = (sumSq - sum * sum / n) / (n * n);
+      if ((d <= (int32_t) m / 2) && ((bestD < 0) || (mser <= best)))
+        {
+          best = mser;
+          bestD = d;
+        }
+    }
+
+  return (bestD == (int32_t) m / 2) ? -1 : bestD * 5;
+}
+
+void
+TidSampler::Fill (SimulationResults &results) const
+{
+  for (uint8_t tid = 0; tid < 8; tid++)
+    {
+      TidResults &r = results.tid[tid];
+      r.samples = m_count;
+
+      std::vector<double> throughput, delay;
+      double lastDelay = 0.0;
+      for (uint32_t i = 0; i < m_count; i++)
+        {
+          const Slot &slot = m_slots[i * 8 + tid];
+          throughput.push_back (slot.rxBytes * 8.0 / m_period.GetMicroSeconds ());
+          if (slot.rxPackets > 0) //empty slots repeat the previous delay
+            lastDelay = (double) slot.delaySum / slot.rxPackets / 1000000;
+          delay.push_back (lastDelay);
+        }
+
+      int32_t d1 = Mser5 (throughput), d2 = Mser5 (delay);
+      if ((d1 < 0) || (d2 < 0))
+        {
+          r.warmup = -1;
+          r.steadyThroughput = 0;
+          r.steadyDelay = 0;
+          r.steadyPackets = 0;
+          continue;
+        }
+
+      uint32_t d = std::max (d1, d2);
+      uint64_t rxBytes = 0, rxPackets = 0;
+      int64_t delaySum = 0;
+      for (uint32_t i = d; i < m_count; i++)
+        {
+          rxBytes += m_slots[i * 8 + tid].rxBytes;
+          rxPackets += m_slots[i * 8 + tid].rxPackets;
+          delaySum += m_slots[i * 8 + tid].delaySum;
+        }
+
+      r.warmup = (m_start + m_period * d).GetSeconds ();
+      r.steadyThroughput = rxBytes * 8.0 / (m_period * (m_count - d)).GetMicroSeconds ();
+      r.steadyDelay = (rxPackets > 0) ? (double) delaySum / rxPackets / 1000000 : 0.0;
+      r.steadyPackets = rxPackets;
+    }
+}
+
+//time series as CSV: end of the sample [s], TID, throughput [Mb/s], mean delay [ms]
+void
+TidSampler::Write (std::string fileName) const
+{
+  std::ofstream out (fileName.c_str ());
+  if (!out)
+    NS_FATAL_ERROR ("Cannot write time series file " << fileName);
+
+  out << "time,tid,throughput,meanDelay" << std::endl;
+  for (uint32_t i = 0; i < m_count; i++)
+    for (uint8_t tid = 0; tid < 8; tid++)
+      {
+        const Slot &slot = m_slots[i * 8 + tid];
+        if (slot.rxPackets == 0)
+          continue;
+        out << (m_start + m_period * (i + 1)).GetSeconds () << "," << (uint16_t) tid << ","
+            << slot.rxBytes * 8.0 / m_period.GetMicroSeconds () << ","
+            << (double) slot.delaySum / slot.rxPackets / 1000000 << std::endl;
+      }
+}
+
+
+
+class SimulationHelper 
+{
+public:
+	SimulationHelper ();
+	
+	static OnOffHelper CreateOnOffHelper(InetSocketAddress socketAddress, DataRate dataRate, int packetSize, uint8_t tid, Time start, Time stop);
+	static void PopulateArpCache (bool permanentEntries);
+	static void InstallSink (Ptr<Node> node, Ipv4Address address, uint16_t port, TidStatistics &tidStats);
+	static void InstallMacSource (Ptr<Node> node, Ptr<Node> dest, uint8_t tid, uint32_t frameSize, uint32_t depth,
+	                              Time start, Time stop, TidStatistics &tidStats);
+	static void InstallBackpressureSource (Ptr<Node> node, InetSocketAddress socketAddress, DataRate dataRate, uint32_t packetSize, uint8_t tid,
+	                                       Time start, Time stop, uint32_t threshold, TidStatistics &tidStats);
+	static void InstallLossCache (Ptr<YansWifiChannel> channel);
+	static Ptr<QosTxop> GetTxop (Ptr<WifiNetDevice> device, uint8_t tid);
+	static Ptr<WifiMacQueue> GetTidQueue (Ptr<WifiNetDevice> device, uint8_t tid);
+	static Ptr<Object> GetQueueController (Ptr<WifiNetDevice> device, uint8_t tid);
+	static void SetMacAttribute (Ptr<WifiNetDevice> device, std::string path, std::string value);
+	static void ConfigureDevices (NetDeviceContainer devices, uint16_t channelWidth, QueueSize maxSize,
+	                              const std::vector<std::pair<std::string, std::string> > &overrides);
+	static void ConfigureWithPaths (uint16_t channelWidth, QueueSize maxSize,
+	                                const std::vector<std::pair<std::string, std::string> > &overrides);
+	static void BenchmarkSetup (std::vector<uint32_t> sizes);
+	static void PrintPerfReport (double wallSeconds, Time simulated);
+
+	static SimulationResults RunSimulation (SimulationParameters params, uint32_t run, bool printFlows,
+	                                        LatencyHistogram *latency = 0, std::vector<SimulationResults> *variantResults = 0);
+	static void PrintResults (const SimulationResults &results);
+	static void WriteBinaryResults (std::string fileName, const SimulationParameters &params, uint32_t run,
+	                                const SimulationResults &results, const TidStatistics &tidStats,
+	                                Ptr<FlowMonitor> monitor, Ptr<Ipv4FlowClassifier> classifier);
+	static SimulationParameters WithFileSuffix (SimulationParameters params, std::string suffix);
+	static std::vector<SimulationResults> RunReplications (const SimulationParameters &params, uint32_t replications, uint32_t jobs);
+	static std::vector<SimulationResults> RunWorkers (const std::vector<std::pair<uint32_t, SimulationParameters> > &runs, uint32_t jobs,
+	                                                  std::vector<LatencyHistogram> *latency);
+	static bool WriteAll (int fd, const void *data, size_t size);
+	static bool ReadAll (int fd, void *data, size_t size);
+
+	static std::vector<std::vector<uint32_t> > PartitionBss (const std::vector<uint16_t> &bssChannel);
+	static SimulationResults RunMultiBss (const SimulationParameters &params, uint32_t jobs);
+	static SimulationResults MergeResults (const std::vector<SimulationResults> &parts, const std::vector<LatencyHistogram> &latency);
+	static std::vector<SimulationResults> RunVariants (SimulationParameters params, uint32_t jobs);
+	static int ForkVariants (const SimulationParameters &params, std::vector<SimulationResults> &results, int &fd);
+	static void ApplyVariant (NodeContainer nodes, const VariantSpec &variant);
+	static void PrintReplicationSummary (const std::vector<SimulationResults> &replications);
+	static double StudentT95 (uint32_t degreesOfFreedom);
+
+	static AnalyticResults AnalyticModel (const SimulationParameters &params);
+	static void PrintAnalytic (const AnalyticResults &model, const SimulationParameters &params, const SimulationResults *simulated);
+
+	static bool SetParameter (SimulationParameters &params, std::string key, std::string value);
+	static std::vector<std::pair<std::string, SimulationParameters> > ParseScenarioFile (std::string fileName, const SimulationParameters &defaults);
+	static std::vector<VariantSpec> ParseVariantFile (std::string fileName);
+};
+
+SimulationHelper::SimulationHelper () 
+{
+}
+
+//prepare CBR traffic source
+OnOffHelper
+SimulationHelper::CreateOnOffHelper(InetSocketAddress socketAddress, DataRate dataRate, int packetSize, uint8_t tid, Time start, Time stop) 
+{
+  socketAddress.SetTos (tid << 5); //(see: https://www.tucny.com/Home/dscp-tos and http://www.revolutionwifi.net/revolutionwifi/2010/08/wireless-qos-part-3-user-priorities.html)
+
+  OnOffHelper onOffHelper  ("ns3::UdpSocketFactory", socketAddress);
+  onOffHelper.SetAttribute ("OnTime",     StringValue   ("ns3::ConstantRandomVariable[Constant=100000]"));
+  onOffHelper.SetAttribute ("OffTime",    StringValue   ("ns3::ConstantRandomVariable[Constant=0]") );
+  onOffHelper.SetAttribute ("DataRate",   DataRateValue (dataRate) );
+  onOffHelper.SetAttribute ("PacketSize", UintegerValue (packetSize) );
+  //onOffHelper.SetAttribute ("Jitter",     DoubleValue (1.0)); //packets generation times modified by random value between -50% and +50% of constant time step between packets
+  //onOffHelper.SetAttribute ("PoissonTraffic", BooleanValue (true)); //generate packets in Poisson process
+  onOffHelper.SetAttribute ("MaxBytes",   UintegerValue (0));
+  onOffHelper.SetAttribute ("StartTime",  TimeValue (start));
+  onOffHelper.SetAttribute ("StopTime",   TimeValue (stop));
+
+  return onOffHelper;
+}
+
+//install UDP sink for one TID and feed its received packets to the per-TID statistics
+void
+SimulationHelper::InstallSink (Ptr<Node> node, Ipv4Address address, uint16_t port, TidStatistics &tidStats)
+{
+  PacketSinkHelper sinkHelper ("ns3::UdpSocketFactory", InetSocketAddress (address, port));
+  ApplicationContainer sink = sinkHelper.Install (node);
+  tidStats.ConnectSink (sink.Get (0));
+}
+
+/* ===== typed per-device configuration ===== */
+
+//one TID per distinct AltEDCA queue: VO/Hi, VO/Low, VI/Hi, VI/Low, BE, BK (the order of A_VO, VO, VI, A_VI, BE, BK)
+static const uint8_t QUEUE_TIDS[6] = { 7, 6, 5, 4, 0, 1 };
+
+//EDCA function serving the given TID (AltEDCA: VO_Txop - A_VO/VO, VI_Txop - VI/A_VI, BE_Txop, BK_Txop)
+Ptr<QosTxop>
+SimulationHelper::GetTxop (Ptr<WifiNetDevice> device, uint8_t tid)
+{
+  static const char *names[8] = { "BE_Txop", "BK_Txop", "BK_Txop", "BE_Txop", "VI_Txop", "VI_Txop", "VO_Txop", "VO_Txop" };
+  PointerValue ptr;
+  device->GetMac ()->GetAttribute (names[tid], ptr);
+  return ptr.Get<QosTxop> ();
+}
+
+//queue holding frames of the given TID: HiTidQueue (A_VO, VI), LowTidQueue (VO, A_VI) or the single Queue of BE/BK
+Ptr<WifiMacQueue>
+SimulationHelper::GetTidQueue (Ptr<WifiNetDevice> device, uint8_t tid)
+{
+  static const char *names[8] = { "Queue", "Queue", "Queue", "Queue", "LowTidQueue", "HiTidQueue", "LowTidQueue", "HiTidQueue" };
+  PointerValue ptr;
+  GetTxop (device, tid)->GetAttribute (names[tid], ptr);
+  return ptr.Get<WifiMacQueue> ();
+}
+
+//losses counted by TidStatistics: drops of the six AltEDCA queues (full queue, lifetime exceeded) and final failures
+//of the MAC (defined here - the queues are looked up with GetTidQueue)
+void
+TidStatistics::ConnectLosses (NetDeviceContainer devices)
+{
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (*i);
+      NS_ASSERT (device != 0);
+      for (uint8_t q = 0; q < 6; q++)
+        {
+          Ptr<WifiMacQueue> queue = SimulationHelper::GetTidQueue (device, QUEUE_TIDS[q]);
+          queue->TraceConnectWithoutContext ("Drop",    MakeCallback (&TidStatistics::NotifyQueueDrop, this));
+          queue->TraceConnectWithoutContext ("Expired", MakeCallback (&TidStatistics::NotifyQueueDrop, this));
+        }
+      if (!device->GetMac ()->TraceConnectWithoutContext ("TxErrHeader", MakeCallback (&TidStatistics::NotifyMacFailure, this)))
+        NS_LOG_WARN ("no TxErrHeader trace - frames failed after the retry limit are reported as in flight");
+    }
+}
+
+//apply channel width, queue sizes and Mac-relative attribute overrides directly on the objects of every device
+//(one pass over the devices instead of resolving a wildcard Config path against every node for each attribute)
+void
+SimulationHelper::ConfigureDevices (NetDeviceContainer devices, uint16_t channelWidth, QueueSize maxSize,
+                                    const std::vector<std::pair<std::string, std::string> > &overrides)
+{
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (*i);
+      NS_ASSERT (device != 0);
+
+      device->GetPhy ()->SetChannelWidth (channelWidth);
+
+      for (uint8_t q = 0; q < 6; q++)
+        GetTidQueue (device, QUEUE_TIDS[q])->SetMaxSize (maxSize);
+
+      for (uint32_t o = 0; o < overrides.size (); o++)
+        SetMacAttribute (device, overrides[o].first, overrides[o].second);
+    }
+}
+
+//set an attribute given by its path relative to the Mac of the device, walking pointer attributes (e.g. VO_Txop/HiTidQueue/MaxDelay)
+void
+SimulationHelper::SetMacAttribute (Ptr<WifiNetDevice> device, std::string path, std::string value)
+{
+  Ptr<Object> object = device->GetMac ();
+  std::string name = path;
+  size_t slash;
+  while ((slash = name.find ('/')) != std::string::npos)
+    {
+      PointerValue ptr;
+      object->GetAttribute (name.substr (0, slash), ptr);
+      object = ptr.Get<Object> ();
+      NS_ASSERT_MSG (object != 0, "no object at " << path);
+      name = name.substr (slash + 1);
+    }
+  object->SetAttribute (name, StringValue (value));
+}
+
+//CBSA controller installed on the queue of a TID by SetQueueControllerForTid (0 - strict priority); found among the
+//pointer attributes of the queue, so that its attributes can be changed at run time
+Ptr<Object>
+SimulationHelper::GetQueueController (Ptr<WifiNetDevice> device, uint8_t tid)
+{
+  Ptr<WifiMacQueue> queue = GetTidQueue (device, tid);
+  for (TypeId t = queue->GetInstanceTypeId (); t != Object::GetTypeId (); t = t.GetParent ())
+    for (uint32_t i = 0; i < t.GetAttributeN (); i++)
+      {
+        TypeId::AttributeInformation info = t.GetAttribute (i);
+        if (!(info.flags & TypeId::ATTR_GET) || (info.checker->GetValueTypeName () != "ns3::PointerValue"))
+          continue;
+        PointerValue ptr;
+        queue->GetAttribute (info.name, ptr);
+        Ptr<Object> object = ptr.Get<Object> ();
+        if ((object != 0) && (object->GetInstanceTypeId ().GetName () == "ns3::CbsaQueueController"))
+          return object;
+      }
+  return 0;
+}
+
+//the same through Config paths (previous approach, kept for comparison - configPaths=1)
+void
+SimulationHelper::ConfigureWithPaths (uint16_t channelWidth, QueueSize maxSize,
+                                      const std::vector<std::pair<std::string, std::string> > &overrides)
+{
+  Config::Set ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/ChannelWidth", UintegerValue (channelWidth) );
+
+  Config::Set ("/NodeList/*/DeviceList/*/Mac/VO_Txop/HiTidQueue/MaxSize",  QueueSizeValue (maxSize) ); //setting A_VO queue size
+  Config::Set ("/NodeList/*/DeviceList/*/Mac/VO_Txop/LowTidQueue/MaxSize", QueueSizeValue (maxSize) ); //setting VO queue size
+  Config::Set ("/NodeList/*/DeviceList/*/Mac/VI_Txop/HiTidQueue/MaxSize",  QueueSizeValue (maxSize) ); //setting VI queue size
+  Config::Set ("/NodeList/*/DeviceList/*/Mac/VI_Txop/LowTidQueue/MaxSize", QueueSizeValue (maxSize) ); //setting A_VI queue size
+  Config::Set ("/NodeList/*/DeviceList/*/Mac/BE_Txop/Queue/MaxSize",       QueueSizeValue (maxSize) ); //setting BE queue size
+  Config::Set ("/NodeList/*/DeviceList/*/Mac/BK_Txop/Queue/MaxSize",       QueueSizeValue (maxSize) ); //setting BK queue size
+
+  for (uint32_t i = 0; i < overrides.size (); i++)
+    Config::Set ("/NodeList/*/DeviceList/*/Mac/" + overrides[i].first, StringValue (overrides[i].second) );
+}
+
+//simulator throughput and memory of the run (perfReport=1)
+void
+SimulationHelper::PrintPerfReport (double wallSeconds, Time simulated)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  uint64_t events = Simulator::GetEventCount ();
+
+  std::ostringstream out;
+  out << "=======================Performance: ===============================" << std::endl;
+  out << "  Wall time:\t"     << wallSeconds << " s" << std::endl;
+  out << "  Simulated time:\t" << simulated.GetSeconds () << " s" << std::endl;
+  out << "  Events:\t"        << events << std::endl;
+  out << "  Events/s:\t"      << (wallSeconds > 0 ? events / wallSeconds : 0) << std::endl;
+  out << "  Wall/sim s:\t"    << (simulated.IsStrictlyPositive () ? wallSeconds / simulated.GetSeconds () : 0) << std::endl;
+  out << "  Peak RSS:\t"      << usage.ru_maxrss << " kB" << std::endl;
+  std::cout << out.str () << std::flush;
+}
+
+//adhoc AltEDCA devices on nSTA+1 fresh nodes (setupBenchmark=1)
+static NetDeviceContainer
+InstallBenchmarkDevices (uint32_t nSTA)
+{
+  NodeContainer sta;
+  sta.Create (nSTA + 1);
+
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
+  YansWifiPhyHelper phy;
+  phy.SetChannel (channel.Create ());
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_STANDARD_80211a);
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac",
+               "QosSupported", BooleanValue (true),
+               "Ssid", SsidValue (Ssid ("TEST")),
+               "AltEDCASupported",   BooleanValue (true));
+  return wifi.Install (phy, mac, sta);
+}
+
+//start-up cost of both configuration approaches for growing number of stations (setupBenchmark=1)
+//each approach configures its own freshly installed devices (none of its writes find the value already set), and the
+//approach timed first alternates between the sizes, so neither one is favoured by caches warmed by the other
+void
+SimulationHelper::BenchmarkSetup (std::vector<uint32_t> sizes)
+{
+  std::vector<std::pair<std::string, std::string> > overrides;
+  overrides.push_back (std::make_pair ("VO_Txop/MinCw", "3"));
+  overrides.push_back (std::make_pair ("BE_Txop/Aifsn", "3"));
+  overrides.push_back (std::make_pair ("VI_Txop/HiTidQueue/MaxDelay", "100ms"));
+
+  std::cout << "nSTA\tConfig::Set [ms]\ttyped [ms]\tspeed-up\tfirst" << std::endl;
+  for (uint32_t i = 0; i < sizes.size (); i++)
+    {
+      double paths = 0, typed = 0;
+      bool typedFirst = (i % 2 == 1);
+      for (uint32_t pass = 0; pass < 2; pass++)
+        {
+          NetDeviceContainer devices = InstallBenchmarkDevices (sizes[i]);
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+          if ((pass == 0) == typedFirst)
+            {
+              ConfigureDevices (devices, 20, QueueSize ("10000p"), overrides);
+              typed = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+            }
+          else
+            {
+              ConfigureWithPaths (20, QueueSize ("10000p"), overrides);
+              paths = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+            }
+          Simulator::Destroy (); //empties the NodeList - the Config paths of the next pass only see its own devices
+        }
+
+      std::cout << sizes[i] << "\t" << paths << "\t" << typed << "\t" << (typed > 0 ? paths / typed : 0)
+                << "\t" << (typedFirst ? "typed" : "Config::Set") << std::endl;
+    }
+}
+
+//fulfill the ARP cache prior to simulation run
+//permanentEntries - mark entries permanent instead of alive, so no dummy packet and header is needed per address
+void
+SimulationHelper::PopulateArpCache (bool permanentEntries) 
+{
+  Ptr<ArpCache> arp = CreateObject<ArpCache> ();
+  arp->SetAliveTimeout (Seconds (3600 * 24 * 365) );
+	
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i) 
+    {	
+      Ptr<Ipv4L3Protocol> ip = (*i)->GetObject<Ipv4L3Protocol> ();
+      NS_ASSERT (ip != 0);
+      ObjectVectorValue interfaces;
+      ip->GetAttribute ("InterfaceList", interfaces);
+
+      for (ObjectVectorValue::Iterator j = interfaces.Begin (); j != interfaces.End (); j++) 
+        {		
+          Ptr<Ipv4Interface> ipIface = (*j).second->GetObject<Ipv4Interface> ();
+          NS_ASSERT (ipIface != 0);
+          Ptr<NetDevice> device = ipIface->GetDevice ();
+          NS_ASSERT (device != 0);
+          Mac48Address addr = Mac48Address::ConvertFrom (device->GetAddress () );
+      
+          for (uint32_t k = 0; k < ipIface->GetNAddresses (); k++) 
+            {			
+              Ipv4Address ipAddr = ipIface->GetAddress (k).GetLocal();		
+              if (ipAddr == Ipv4Address::GetLoopback ()) 
+                continue;
+
+              ArpCache::Entry *entry = arp->Add (ipAddr);
+              if (permanentEntries)
+                {
+                  entry->SetMacAddress (addr);
+                  entry->MarkPermanent ();
+                  continue;
+                }
+              Ipv4Header ipv4Hdr;
+              ipv4Hdr.SetDestination (ipAddr);
+              Ptr<Packet> p = Create<Packet> (100);  
+              entry->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (p, ipv4Hdr) );
+              entry->MarkAlive (addr);
+            }
+        }
+    }
+
+    for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i) 
+      {
+        Ptr<Ipv4L3Protocol> ip = (*i)->GetObject<Ipv4L3Protocol> ();
+		NS_ASSERT (ip != 0);
+		ObjectVectorValue interfaces;
+		ip->GetAttribute ("InterfaceList", interfaces);
+
+        for (ObjectVectorValue::Iterator j = interfaces.Begin (); j != interfaces.End (); j ++)
+          {
+            Ptr<Ipv4Interface> ipIface = (*j).second->GetObject<Ipv4Interface> ();
+            ipIface->SetAttribute ("ArpCache", PointerValue (arp) );
+          }
+      }
+}
+
+
+
+//two-sided 95% quantile of Student's t distribution
+double
+SimulationHelper::StudentT95 (uint32_t degreesOfFreedom)
+{
+  static const double table[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+  if (degreesOfFreedom == 0)
+    return 0.0;
+  if (degreesOfFreedom <= 30)
+    return table[degreesOfFreedom - 1];
+  if (degreesOfFreedom <= 40)
+    return 2.021;
+  if (degreesOfFreedom <= 60)
+    return 2.000;
+  if (degreesOfFreedom <= 120)
+    return 1.980;
+  return 1.960;
+}
+
+//output files of one of several runs of a scenario - the suffix (e.g. "-run3") appended to every file name
+SimulationParameters
+SimulationHelper::WithFileSuffix (SimulationParameters params, std::string suffix)
+{
+  std::string *files[] = { &params.resultsFile, &params.sampleFile, &params.eventTrace, &params.pcapFile, &params.queueSampleFile };
+  for (uint32_t i = 0; i < sizeof (files) / sizeof (files[0]); i++)
+    if (!files[i]->empty ())
+      *files[i] += suffix;
+  return params;
+}
+
+//run independent replications in isolated worker processes (Simulator is a process singleton, so each replication is forked)
+//the seed is kept and the run number is varied, as recommended for independent ns-3 replications
+std::vector<SimulationResults>
+SimulationHelper::RunReplications (const SimulationParameters &params, uint32_t replications, uint32_t jobs)
+{
+  std::vector<std::pair<uint32_t, SimulationParameters> > runs;
+  for (uint32_t r = 1; r <= replications; r++)
+    {
+      std::ostringstream suffix;
+      suffix << "-run" << r;
+      runs.push_back (std::make_pair (r, WithFileSuffix (params, suffix.str ())));
+    }
+  return RunWorkers (runs, jobs, 0);
+}
+
+//every (run number, parameters) in its own forked worker, at most jobs at a time; the results are sent back
+//through a pipe as raw bytes, followed by the 8 per-TID delay histograms if latency is given (8 per run)
+std::vector<SimulationResults>
+SimulationHelper::RunWorkers (const std::vector<std::pair<uint32_t, SimulationParameters> > &runs, uint32_t jobs,
+                              std::vector<LatencyHistogram> *latency)
+{
+  std::vector<SimulationResults> results (runs.size ());
+  if (latency != 0)
+    latency->assign (runs.size () * 8, LatencyHistogram ());
+  std::map<pid_t, std::pair<uint32_t, int> > workers; //worker pid -> (index in runs, pipe read end)
+  uint32_t next = 0;
+
+  std::cout.flush ();
+  while ((next < runs.size ()) || !workers.empty ())
+    {
+      if ((next < runs.size ()) && (workers.size () < jobs))
+        {
+          int fd[2];
+          if (pipe (fd) != 0)
+            NS_FATAL_ERROR ("pipe () failed: " << std::strerror (errno));
+
+          pid_t pid = fork ();
+          if (pid < 0)
+            NS_FATAL_ERROR ("fork () failed: " << std::strerror (errno));
+
+          if (pid == 0) //worker
+            {
+              close (fd[0]);
+              std::vector<LatencyHistogram> histograms (8);
+              SimulationResults r = RunSimulation (runs[next].second, runs[next].first, false, &histograms[0]);
+              //both fit the pipe buffer (64 KiB), so the worker can exit before being read
+              if (!WriteAll (fd[1], &r, sizeof (r))
+                  || ((latency != 0) && !WriteAll (fd[1], &histograms[0], 8 * sizeof (LatencyHistogram))))
+                _exit (1);
+              close (fd[1]);
+              std::cout.flush ();
+              _exit (0);
+            }
+
+          close (fd[1]);
+          workers[pid] = std::make_pair (next, fd[0]);
+          next++;
+          continue;
+        }
+
+      //all job slots busy (or nothing left to start) - collect the next finished worker
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          NS_FATAL_ERROR ("waitpid () failed: " << std::strerror (errno));
+        }
+
+      std::map<pid_t, std::pair<uint32_t, int> >::iterator w = workers.find (pid);
+      if (w == workers.end ())
+        continue;
+
+      uint32_t index = w->second.first;
+      bool complete = ReadAll (w->second.second, &results[index], sizeof (SimulationResults));
+      if (complete && (latency != 0))
+        complete = ReadAll (w->second.second, &(*latency)[index * 8], 8 * sizeof (LatencyHistogram));
+      close (w->second.second);
+      workers.erase (w);
+
+      if (!WIFEXITED (status) || (WEXITSTATUS (status) != 0) || !complete)
+        NS_FATAL_ERROR ("run " << runs[index].first << " failed");
+    }
+
+  return results;
+}
+
+//pipe transfers of the workers (restarted after signals)
+bool
+SimulationHelper::WriteAll (int fd, const void *data, size_t size)
+{
+  const char *buf = static_cast<const char *> (data);
+  while (size > 0)
+    {
+      ssize_t n = write (fd, buf, size);
+      if ((n < 0) && (errno == EINTR))
+        continue;
+      if (n <= 0)
+        return false;
+      buf += n;
+      size -= n;
+    }
+  return true;
+}
+
+bool
+SimulationHelper::ReadAll (int fd, void *data, size_t size)
+{
+  char *buf = static_cast<char *> (data);
+  while (size > 0)
+    {
+      ssize_t n = read (fd, buf, size);
+      if ((n < 0) && (errno == EINTR))
+        continue;
+      if (n <= 0)
+        return false;
+      buf += n;
+      size -= n;
+    }
+  return true;
+}
+
+//mean, standard deviation and 95% confidence interval of one metric over replications
+static void
+PrintReplicationLine (std::string label, const std::vector<double> &samples, std::string unit)
+{
+  if (samples.empty ())
+    {
+      std::cout << "  " << label << ":\t---" << std::endl;
+      return;
+    }
+
+  double mean = 0.0, var = 0.0;
+  for (uint32_t i = 0; i < samples.size (); i++)
+    mean += samples[i];
+  mean /= samples.size ();
+  for (uint32_t i = 0; i < samples.size (); i++)
+    var += (samples[i] - mean) * (samples[i] - mean);
+  var = (samples.size () > 1) ? var / (samples.size () - 1) : 0.0;
+
+  double stdDev = std::sqrt (var);
+  double halfWidth = SimulationHelper::StudentT95 (samples.size () - 1) * stdDev / std::sqrt ((double) samples.size ());
+
+  std::cout << "  " << label << ":\t" << mean << " " << unit
+            << " (std " << stdDev << ", 95% CI +/- " << halfWidth << ", n=" << samples.size () << ")" << std::endl;
+}
+
+void
+SimulationHelper::PrintReplicationSummary (const std::vector<SimulationResults> &replications)
+{
+  for (uint16_t tid = 0; tid <= 8; tid++)
+    {
+      if ((tid == 2) || (tid == 3))
+        continue;
+
+      std::vector<double> throughput, delay, jitter, lost, warmup, steadyThroughput, steadyDelay, p50, p99, p999;
+      for (uint32_t r = 0; r < replications.size (); r++)
+        {
+          if ((tid < 8) && (replications[r].tid[tid].warmup >= 0) && (replications[r].tid[tid].samples > 0))
+            {
+              warmup.push_back (replications[r].tid[tid].warmup);
+              steadyThroughput.push_back (replications[r].tid[tid].steadyThroughput);
+              steadyDelay.push_back (replications[r].tid[tid].steadyDelay);
+            }
+
+          TidResults t;
+          std::memset (&t, 0, sizeof (t));
+          for (uint16_t i = 0; i < 8; i++) //tid == 8 stands for total
+            if ((tid == 8) || (tid == i))
+              {
+                const TidResults &s = replications[r].tid[i];
+                t.txPackets   += s.txPackets;
+                t.rxPackets   += s.rxPackets;
+                t.lostPackets += s.lostPackets;
+                t.throughput  += s.throughput;
+                t.delaySum    += s.delaySum;
+                t.jitterSum   += s.jitterSum;
+              }
+
+          throughput.push_back (t.throughput);
+          lost.push_back (t.lostPackets);
+          if (t.rxPackets > 0)
+            {
+              delay.push_back ((double) t.delaySum / t.rxPackets / 1000000);
+              p50.push_back ((tid < 8) ? replications[r].tid[tid].delayP50 : replications[r].totalDelayP50);
+              p99.push_back ((tid < 8) ? replications[r].tid[tid].delayP99 : replications[r].totalDelayP99);
+              p999.push_back ((tid < 8) ? replications[r].tid[tid].delayP999 : replications[r].totalDelayP999);
+            }
+          if (t.rxPackets > 1)
+            jitter.push_back ((double) t.jitterSum / (t.rxPackets - 1) / 1000000);
+        }
+
+      if (tid == 8)
+        std::cout << "=======================Total (" << replications.size () << " replications): =====================" << std::endl;
+      else
+        std::cout << "=======================TID: " << tid << " (" << replications.size () << " replications) =====================" << std::endl;
+
+      PrintReplicationLine ("Throughput",   throughput, "Mb/s");
+      PrintReplicationLine ("Mean delay",   delay,      "ms");
+      PrintReplicationLine ("Delay p50",    p50,        "ms");
+      PrintReplicationLine ("Delay p99",    p99,        "ms");
+      PrintReplicationLine ("Delay p99.9",  p999,       "ms");
+      PrintReplicationLine ("Mean jitter",  jitter,     "ms");
+      PrintReplicationLine ("Lost packets", lost,       "pkts");
+      if ((tid < 8) && (replications[0].tid[tid].samples > 0))
+        {
+          PrintReplicationLine ("Warm-up (MSER-5)",   warmup,           "s");
+          PrintReplicationLine ("Steady throughput",  steadyThroughput, "Mb/s");
+          PrintReplicationLine ("Steady mean delay",  steadyDelay,      "ms");
+        }
+    }
+
+  std::vector<double> stopTime;
+  for (uint32_t r = 0; r < replications.size (); r++)
+    if (replications[r].ciReached)
+      stopTime.push_back (replications[r].stopTime);
+  if (!stopTime.empty ()) //ciTarget reached by some of the replications
+    PrintReplicationLine ("Stopped at", stopTime, "s");
+}
+
+
+
+/* ===== multi-BSS partitions ===== */
+
+//BSSs interact only through a shared YansWifiChannel - BSSs on the same channel are one partition (union-find),
+//every partition is an independent simulation
+std::vector<std::vector<uint32_t> >
+SimulationHelper::PartitionBss (const std::vector<uint16_t> &bssChannel)
+{
+  std::vector<uint32_t> parent (bssChannel.size ());
+  std::map<uint16_t, uint32_t> first; //channel -> first BSS on it
+  for (uint32_t b = 0; b < bssChannel.size (); b++)
+    {
+      parent[b] = b;
+      std::map<uint16_t, uint32_t>::iterator f = first.find (bssChannel[b]);
+      if (f == first.end ())
+        {
+          first[bssChannel[b]] = b;
+          continue;
+        }
+      uint32_t root = f->second;
+      while (parent[root] != root)
+        root = parent[root];
+      parent[b] = root;
+    }
+
+  std::vector<std::vector<uint32_t> > partitions;
+  std::map<uint32_t, uint32_t> index; //root -> partition
+  for (uint32_t b = 0; b < bssChannel.size (); b++)
+    {
+      uint32_t root = b;
+      while (parent[root] != root)
+        root = parent[root];
+      if (index.find (root) == index.end ())
+        {
+          index[root] = partitions.size ();
+          partitions.push_back (std::vector<uint32_t> ());
+        }
+      partitions[index[root]].push_back (b);
+    }
+  return partitions;
+}
+
+//nBss co-located BSSs of staPerBss stations each, spread over bssChannels 20 MHz channels of 802.11a;
+//every partition runs in its own worker process (its own Simulator and event queue), the per-TID results are merged
+SimulationResults
+SimulationHelper::RunMultiBss (const SimulationParameters &params, uint32_t jobs)
+{
+  static const uint16_t channels[] = { 36, 40, 44, 48, 52, 56, 60, 64, 100, 104, 108, 112,
+                                       116, 120, 124, 128, 132, 136, 140, 149, 153, 157, 161, 165 };
+  uint32_t nChannels = sizeof (channels) / sizeof (channels[0]);
+  if ((params.bssChannels > 0) && (params.bssChannels < nChannels))
+    nChannels = params.bssChannels;
+
+  std::vector<uint16_t> bssChannel (params.nBss);
+  for (uint32_t b = 0; b < params.nBss; b++)
+    bssChannel[b] = channels[b % nChannels];
+  std::vector<std::vector<uint32_t> > partitions = PartitionBss (bssChannel);
+
+  std::vector<std::pair<uint32_t, SimulationParameters> > runs;
+  for (uint32_t p = 0; p < partitions.size (); p++)
+    {
+      std::ostringstream suffix;
+      suffix << "-ch" << bssChannel[partitions[p][0]];
+      SimulationParameters partition = WithFileSuffix (params, suffix.str ());
+      partition.nBss = 0;
+      partition.nSTA = (params.staPerBss > 0) ? params.staPerBss : params.nSTA;
+      partition.coChannelBss = partitions[p].size ();
+      partition.channelNumber = bssChannel[partitions[p][0]];
+      runs.push_back (std::make_pair (p + 1, partition)); //run numbers 1..P - independent random streams
+    }
+
+  std::cout << "Multi-BSS: " << params.nBss << " BSSs on " << std::min<uint32_t> (nChannels, params.nBss) << " channels, "
+            << partitions.size () << " partitions on " << std::min<uint32_t> (jobs, partitions.size ()) << " workers" << std::endl;
+  std::vector<LatencyHistogram> latency;
+  std::vector<SimulationResults> results = RunWorkers (runs, jobs, &latency);
+
+  for (uint32_t p = 0; p < partitions.size (); p++)
+    {
+      double throughput = 0;
+      for (uint8_t tid = 0; tid < 8; tid++)
+        throughput += results[p].tid[tid].throughput;
+      std::cout << "  Channel " << runs[p].second.channelNumber << ":\t" << partitions[p].size () << " BSS, "
+                << throughput << " Mb/s" << std::endl;
+    }
+  return MergeResults (results, latency);
+}
+
+//sums of the per-TID counters and throughputs of simultaneous, independent partitions;
+//delay percentiles from the merged histograms (8 per partition)
+SimulationResults
+SimulationHelper::MergeResults (const std::vector<SimulationResults> &parts, const std::vector<LatencyHistogram> &latency)
+{
+  SimulationResults merged;
+  std::memset (&merged, 0, sizeof (merged));
+  merged.ciReached = !parts.empty ();
+
+  LatencyHistogram total;
+  for (uint8_t tid = 0; tid < 8; tid++)
+    {
+      TidResults &m = merged.tid[tid];
+      LatencyHistogram histogram;
+      double steadyDelaySum = 0;
+      uint64_t steadyPackets = 0;
+      for (uint32_t p = 0; p < parts.size (); p++)
+        {
+          const TidResults &r = parts[p].tid[tid];
+          m.txBytes        += r.txBytes;
+          m.rxBytes        += r.rxBytes;
+          m.txPackets      += r.txPackets;
+          m.rxPackets      += r.rxPackets;
+          m.lostPackets    += r.lostPackets;
+          m.inFlightPackets += r.inFlightPackets;
+          m.throughput     += r.throughput;
+          m.delaySum       += r.delaySum;
+          m.jitterSum      += r.jitterSum;
+          m.offeredPackets += r.offeredPackets;
+          m.offeredLoad    += r.offeredLoad;
+          m.samples        += r.samples;
+          if ((p == 0) || (r.warmup < 0) || (m.warmup < 0)) //-1 if any partition has no steady state
+            m.warmup = (p == 0) ? r.warmup : -1;
+          else
+            m.warmup = std::max (m.warmup, r.warmup);
+          m.steadyThroughput += r.steadyThroughput;
+          steadyDelaySum   += r.steadyDelay * r.steadyPackets;
+          steadyPackets    += r.steadyPackets;
+          histogram.Add (latency[p * 8 + tid]);
+        }
+      m.steadyDelay = (steadyPackets > 0) ? steadyDelaySum / steadyPackets : 0;
+      m.steadyPackets = steadyPackets;
+      m.delayP50    = histogram.GetPercentile (0.5);
+      m.delayP99    = histogram.GetPercentile (0.99);
+      m.delayP999   = histogram.GetPercentile (0.999);
+      total.Add (histogram);
+    }
+  merged.totalDelayP50  = total.GetPercentile (0.5);
+  merged.totalDelayP99  = total.GetPercentile (0.99);
+  merged.totalDelayP999 = total.GetPercentile (0.999);
+
+  merged.partitions = parts.size ();
+  uint32_t queueNodes = 0; //of the partitions with queue statistics
+  for (uint32_t p = 0; p < parts.size (); p++)
+    {
+      merged.nodes += parts[p].nodes;
+      merged.stopTime = std::max (merged.stopTime, parts[p].stopTime);
+      merged.ciReached = merged.ciReached && parts[p].ciReached;
+      if (!parts[p].queueStats)
+        continue;
+      merged.queueStats = true;
+      merged.queuedPeakPackets += parts[p].queuedPeakPackets; //the partitions peak at different times - an upper bound
+      merged.queuedPeakBytes += parts[p].queuedPeakBytes;
+      queueNodes += parts[p].nodes;
+      for (uint8_t q = 0; q < 6; q++)
+        {
+          QueueResults &m = merged.queue[q];
+          const QueueResults &r = parts[p].queue[q];
+          if (r.peak > m.peak)
+            {
+              m.peak = r.peak;
+              m.peakNode = r.peakNode;
+            }
+          m.meanAverage += r.meanAverage * parts[p].nodes; //partitions of different size (nBss not a multiple of bssChannels)
+          m.maxAverage = std::max (m.maxAverage, r.maxAverage);
+        }
+    }
+  for (uint8_t q = 0; (q < 6) && (queueNodes > 0); q++)
+    merged.queue[q].meanAverage /= queueNodes;
+  return merged;
+}
+
+
+
+/* ===== sequential stopping ===== */
+
+//batch means over the samples after calcStart: BATCHES batches of equal length (the slots merged by
+//the sampler keep the batch count fixed as the run grows), Student-t 95% CI of throughput and mean delay
+bool
+TidSampler::CheckPrecision (void) const
+{
+  static const uint32_t BATCHES = 20;
+
+  uint32_t first = (m_calcStart > m_start) ? (uint32_t) std::ceil ((m_calcStart - m_start).GetSeconds () / m_period.GetSeconds ()) : 0;
+  if (m_count < first + BATCHES)
+    return false;
+  uint32_t batchSize = (m_count - first) / BATCHES;
+
+  for (uint8_t tid = 0; tid < 8; tid++)
+    {
+      if (!(m_tidMask & (1 << tid)))
+        continue;
+
+      std::vector<double> throughput, delay;
+      for (uint32_t b = 0; b < BATCHES; b++)
+        {
+          uint64_t rxBytes = 0, rxPackets = 0;
+          int64_t delaySum = 0;
+          for (uint32_t i = first + b * batchSize; i < first + (b + 1) * batchSize; i++)
+            {
+              rxBytes += m_slots[i * 8 + tid].rxBytes;
+              rxPackets += m_slots[i * 8 + tid].rxPackets;
+              delaySum += m_slots[i * 8 + tid].delaySum;
+            }
+          if (rxPackets == 0) //starved batch - no estimate yet
+            return false;
+          throughput.push_back (rxBytes * 8.0 / (m_period * batchSize).GetMicroSeconds ());
+          delay.push_back ((double) delaySum / rxPackets);
+        }
+
+      const std::vector<double> *metrics[2] = { &throughput, &delay };
+      for (uint8_t k = 0; k < 2; k++)
+        {
+          const std::vector<double> &x = *metrics[k];
+          double mean = 0.0, var = 0.0;
+          for (uint32_t b = 0; b < BATCHES; b++)
+            mean += x[b];
+          mean /= BATCHES;
+          for (uint32_t b = 0; b < BATCHES; b++)
+            var += (x[b] - mean) * (x[b] - mean);
+          var /= BATCHES - 1;
+
+          double halfWidth = SimulationHelper::StudentT95 (BATCHES - 1) * std::sqrt (var / BATCHES);
+          if ((mean <= 0) || (halfWidth / mean > m_ciTarget))
+            return false;
+        }
+    }
+
+  return true;
+}
+
+
+
+/* ===== MAC-level saturated traffic source ===== */
+
+//keeps the queue of one TID topped up to a few frames by enqueuing directly at the WifiNetDevice
+//(no per-packet timer, UDP socket or IPv4 processing) - refilled whenever the queue occupancy drops
+class SaturatedMacSource : public Application
+{
+public:
+  static const uint16_t PROTOCOL = 0x88b5; //IEEE 802 local experimental EtherType
+
+  static TypeId GetTypeId (void);
+  SaturatedMacSource ();
+
+  void Setup (Ptr<WifiNetDevice> device, Mac48Address destination, uint8_t tid, uint32_t frameSize, uint32_t depth, TidStatistics *tidStats);
+  uint8_t GetTid (void) const;
+  void Stop (void); //before the stop time (variant switching the TID off)
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  void QueueChanged (uint32_t oldValue, uint32_t newValue);
+  void TopUp (void);
+
+  Ptr<WifiNetDevice> m_device;
+  Ptr<WifiMacQueue> m_queue;
+  Mac48Address m_destination;
+  uint8_t m_tid;
+  uint32_t m_frameSize;
+  uint32_t m_depth;
+  TidStatistics *m_tidStats;
+  bool m_running;
+  bool m_inTopUp; //enqueuing from TopUp - its own changes need no refill
+  EventId m_topUpEvent;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SaturatedMacSource);
+
+TypeId
+SaturatedMacSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SaturatedMacSource")
+    .SetParent<Application> ()
+    .AddConstructor<SaturatedMacSource> ()
+  ;
+  return tid;
+}
+
+SaturatedMacSource::SaturatedMacSource ()
+  : m_tid (0),
+    m_frameSize (0),
+    m_depth (2),
+    m_tidStats (0),
+    m_running (false),
+    m_inTopUp (false)
+{
+}
+
+void
+SaturatedMacSource::Setup (Ptr<WifiNetDevice> device, Mac48Address destination, uint8_t tid, uint32_t frameSize, uint32_t depth, TidStatistics *tidStats)
+{
+  m_device = device;
+  m_queue = SimulationHelper::GetTidQueue (device, tid);
+  m_destination = destination;
+  m_tid = tid;
+  m_frameSize = frameSize;
+  m_depth = std::max (depth, 1u);
+  m_tidStats = tidStats;
+}
+
+uint8_t
+SaturatedMacSource::GetTid (void) const
+{
+  return m_tid;
+}
+
+void
+SaturatedMacSource::Stop (void)
+{
+  StopApplication ();
+}
+
+void
+SaturatedMacSource::StartApplication (void)
+{
+  m_running = true;
+  //never more than the queue holds (its limit is set by ConfigureDevices or a MaxSize override before the start)
+  m_depth = std::min (m_depth, m_queue->GetMaxSize ().GetValue ());
+  m_queue->TraceConnectWithoutContext ("PacketsInQueue", MakeCallback (&SaturatedMacSource::QueueChanged, this));
+  TopUp ();
+}
+
+void
+SaturatedMacSource::StopApplication (void)
+{
+  m_running = false;
+  m_queue->TraceDisconnectWithoutContext ("PacketsInQueue", MakeCallback (&SaturatedMacSource::QueueChanged, this));
+  Simulator::Cancel (m_topUpEvent);
+}
+
+//called on every enqueue/dequeue/drop - only a decrease outside TopUp needs a refill (done in a separate event,
+//not from inside the EDCA dequeue path)
+void
+SaturatedMacSource::QueueChanged (uint32_t oldValue, uint32_t newValue)
+{
+  if (m_inTopUp || (newValue >= oldValue))
+    return;
+  if (m_running && (newValue < m_depth) && !m_topUpEvent.IsRunning ())
+    m_topUpEvent = Simulator::ScheduleNow (&SaturatedMacSource::TopUp, this);
+}
+
+void
+SaturatedMacSource::TopUp (void)
+{
+  m_inTopUp = true;
+  while (m_running && (m_queue->GetNPackets () < m_depth))
+    {
+      uint32_t queued = m_queue->GetNPackets ();
+      Ptr<Packet> packet = Create<Packet> (m_frameSize);
+      SocketPriorityTag priority; //TID used by the MAC to select the EDCA queue
+      priority.SetPriority (m_tid);
+      packet->AddPacketTag (priority);
+      m_tidStats->NotifyMacTx (m_tid, packet);
+      //refused or dropped at enqueue (e.g. MaxSize in bytes) - retried on the next dequeue instead of spinning here
+      if (!m_device->Send (packet, m_destination, PROTOCOL) || (m_queue->GetNPackets () <= queued))
+        break;
+    }
+  m_inTopUp = false;
+}
+
+
+
+//install MAC-level saturated source of one TID on node, sending to the WiFi device of dest
+void
+SimulationHelper::InstallMacSource (Ptr<Node> node, Ptr<Node> dest, uint8_t tid, uint32_t frameSize, uint32_t depth,
+                                    Time start, Time stop, TidStatistics &tidStats)
+{
+  Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (node->GetDevice (0));
+  Ptr<WifiNetDevice> destDevice = DynamicCast<WifiNetDevice> (dest->GetDevice (0));
+  NS_ASSERT ((device != 0) && (destDevice != 0));
+
+  Ptr<SaturatedMacSource> source = CreateObject<SaturatedMacSource> ();
+  source->Setup (device, Mac48Address::ConvertFrom (destDevice->GetAddress ()), tid, frameSize, depth, &tidStats);
+  source->SetStartTime (start);
+  source->SetStopTime (stop);
+  node->AddApplication (source);
+
+  tidStats.ConnectMacSink (dest, SaturatedMacSource::PROTOCOL);
+}
+
+
+
+/* ===== queue-aware CBR traffic source ===== */
+
+//CBR source equivalent to CreateOnOffHelper, but paused while the WiFi queue of its TID holds threshold packets or more
+//(bytes for a queue limited in bytes - the packets would only be dropped there) - resumed on the first CBR slot after
+//the queue drains; skipped slots still count as offered load
+class BackpressureSource : public Application
+{
+public:
+  static TypeId GetTypeId (void);
+  BackpressureSource ();
+
+  void Setup (InetSocketAddress peer, DataRate dataRate, uint32_t packetSize, uint8_t tid, Ptr<WifiMacQueue> queue,
+              uint32_t threshold, TidStatistics *tidStats);
+  uint8_t GetTid (void) const;
+  void Stop (void); //before the stop time (variant switching the TID off)
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  bool QueueFull (void) const;
+  uint64_t SkippedSlots (void) const;
+  void QueueChanged (uint32_t oldValue, uint32_t newValue);
+  void SendPacket (void);
+
+  Ptr<Socket> m_socket;
+  InetSocketAddress m_peer;
+  Time m_interval;
+  uint32_t m_packetSize;
+  uint8_t m_tid;
+  Ptr<WifiMacQueue> m_queue;
+  uint32_t m_threshold;
+  TidStatistics *m_tidStats;
+  bool m_paused;
+  Time m_pausedAt; //CBR slot of the first packet skipped
+  EventId m_sendEvent;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (BackpressureSource);
+
+TypeId
+BackpressureSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BackpressureSource")
+    .SetParent<Application> ()
+    .AddConstructor<BackpressureSource> ()
+  ;
+  return tid;
+}
+
+BackpressureSource::BackpressureSource ()
+  : m_peer (Ipv4Address::GetAny (), 0),
+    m_packetSize (0),
+    m_tid (0),
+    m_threshold (0),
+    m_tidStats (0),
+    m_paused (false)
+{
+}
+
+void
+BackpressureSource::Setup (InetSocketAddress peer, DataRate dataRate, uint32_t packetSize, uint8_t tid, Ptr<WifiMacQueue> queue,
+                           uint32_t threshold, TidStatistics *tidStats)
+{
+  m_peer = peer;
+  m_peer.SetTos (tid << 5);
+  m_interval = dataRate.CalculateBytesTxTime (packetSize);
+  m_packetSize = packetSize;
+  m_tid = tid;
+  m_queue = queue;
+  m_threshold = threshold;
+  m_tidStats = tidStats;
+}
+
+uint8_t
+BackpressureSource::GetTid (void) const
+{
+  return m_tid;
+}
+
+void
+BackpressureSource::Stop (void)
+{
+  StopApplication ();
+}
+
+void
+BackpressureSource::StartApplication (void)
+{
+  if (m_threshold == 0) //default: the queue limit, in its unit (set by ConfigureDevices before the applications start)
+    m_threshold = m_queue->GetMaxSize ().GetValue ();
+
+  m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
+  m_socket->Bind ();
+  m_socket->Connect (m_peer);
+  m_socket->ShutdownRecv ();
+
+  m_queue->TraceConnectWithoutContext ("PacketsInQueue", MakeCallback (&BackpressureSource::QueueChanged, this));
+  m_paused = false;
+  SendPacket ();
+}
+
+void
+BackpressureSource::StopApplication (void)
+{
+  m_queue->TraceDisconnectWithoutContext ("PacketsInQueue", MakeCallback (&BackpressureSource::QueueChanged, this));
+  Simulator::Cancel (m_sendEvent);
+  if (m_paused) //packets skipped until the end of the run
+    m_tidStats->NotifyOffered (m_tid, SkippedSlots (), m_packetSize + 28);
+  m_paused = false;
+  if (m_socket != 0) //stopped twice if stopped early by Stop
+    {
+      m_socket->Close ();
+      m_socket = 0;
+    }
+}
+
+//occupancy compared in the unit of the queue limit (a byte limit can be reached with few packets)
+bool
+BackpressureSource::QueueFull (void) const
+{
+  if (m_queue->GetMaxSize ().GetUnit () == QueueSizeUnit::BYTES)
+    return (m_queue->GetNBytes () >= m_threshold);
+  return (m_queue->GetNPackets () >= m_threshold);
+}
+
+//CBR slots from m_pausedAt (included) up to now (excluded) - none if resumed at the instant of the pause
+uint64_t
+BackpressureSource::SkippedSlots (void) const
+{
+  int64_t elapsed = (Simulator::Now () - m_pausedAt).GetTimeStep ();
+  int64_t interval = m_interval.GetTimeStep ();
+  return (elapsed + interval - 1) / interval;
+}
+
+void
+BackpressureSource::QueueChanged (uint32_t oldValue, uint32_t newValue)
+{
+  if (!m_paused || QueueFull ())
+    return;
+
+  //packets that would have been generated (and dropped) while paused - sending resumes on the CBR grid
+  uint64_t skipped = SkippedSlots ();
+  m_tidStats->NotifyOffered (m_tid, skipped, m_packetSize + 28);
+  m_paused = false;
+  Time next = TimeStep (m_pausedAt.GetTimeStep () + skipped * m_interval.GetTimeStep ());
+  m_sendEvent = Simulator::Schedule (next - Simulator::Now (), &BackpressureSource::SendPacket, this);
+}
+
+void
+BackpressureSource::SendPacket (void)
+{
+  if (QueueFull ())
+    {
+      m_paused = true;
+      m_pausedAt = Simulator::Now ();
+      return;
+    }
+
+  m_tidStats->NotifyOffered (m_tid, 1, m_packetSize + 28); //as counted at the IP layer
+  m_socket->Send (Create<Packet> (m_packetSize));
+  m_sendEvent = Simulator::Schedule (m_interval, &BackpressureSource::SendPacket, this);
+}
+
+
+
+//install queue-aware CBR source of one TID on node (threshold 0: the queue limit)
+void
+SimulationHelper::InstallBackpressureSource (Ptr<Node> node, InetSocketAddress socketAddress, DataRate dataRate, uint32_t packetSize, uint8_t tid,
+                                             Time start, Time stop, uint32_t threshold, TidStatistics &tidStats)
+{
+  Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (node->GetDevice (0));
+  NS_ASSERT (device != 0);
+
+  Ptr<BackpressureSource> source = CreateObject<BackpressureSource> ();
+  source->Setup (socketAddress, dataRate, packetSize, tid, GetTidQueue (device, tid), threshold, &tidStats);
+  source->SetStartTime (start);
+  source->SetStopTime (stop);
+  node->AddApplication (source);
+}
+
+
+
+/* ===== fork-after-warm-up variants ===== */
+
+//simulate the scenario once up to branchTime, then continue it once per variant in a forked child - the warm-up
+//is shared, and every variant starts from the same state and random streams as the base
+std::vector<SimulationResults>
+SimulationHelper::RunVariants (SimulationParameters params, uint32_t jobs)
+{
+  if ((params.branchTime <= 0) || (params.branchTime >= params.simTime))
+    NS_FATAL_ERROR ("variants need 0 < branchTime < simTime");
+  if (params.nBss > 0)
+    NS_FATAL_ERROR ("variants cannot be combined with nBss");
+  if (params.ciTarget > 0)
+    NS_FATAL_ERROR ("variants cannot be combined with ciTarget (every variant runs to simTime)");
+  if (!params.eventTrace.empty () || !params.pcapFile.empty () || !params.queueSampleFile.empty ())
+    NS_FATAL_ERROR ("eventTrace, pcapFile and queueSampleFile are opened before the branch and cannot be shared by the variants");
+
+  params.variantJobs = jobs;
+  std::vector<SimulationResults> results (params.variants.size ());
+  RunSimulation (params, 1, false, 0, &results);
+  return results;
+}
+
+//called at the branch time: one child per variant, at most variantJobs at a time, each sending its results back through
+//a pipe as in RunWorkers. The children get the simulator state copy-on-write, so nothing has to be serialized.
+//Returns the variant a child has to continue (fd - write end of its pipe), or -1 in the parent once all are collected
+int
+SimulationHelper::ForkVariants (const SimulationParameters &params, std::vector<SimulationResults> &results, int &fd)
+{
+  std::map<pid_t, std::pair<uint32_t, int> > children; //child pid -> (variant, pipe read end)
+  uint32_t next = 0;
+
+  std::cout.flush ();
+  while ((next < params.variants.size ()) || !children.empty ())
+    {
+      if ((next < params.variants.size ()) && (children.size () < std::max (params.variantJobs, 1u)))
+        {
+          int pipeFd[2];
+          if (pipe (pipeFd) != 0)
+            NS_FATAL_ERROR ("pipe () failed: " << std::strerror (errno));
+
+          pid_t pid = fork ();
+          if (pid < 0)
+            NS_FATAL_ERROR ("fork () failed: " << std::strerror (errno));
+
+          if (pid == 0) //child - returns to the simulation
+            {
+              close (pipeFd[0]);
+              for (std::map<pid_t, std::pair<uint32_t, int> >::iterator c = children.begin (); c != children.end (); c++)
+                close (c->second.second);
+              fd = pipeFd[1];
+              return next;
+            }
+
+          close (pipeFd[1]);
+          children[pid] = std::make_pair (next, pipeFd[0]);
+          next++;
+          continue;
+        }
+
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          NS_FATAL_ERROR ("waitpid () failed: " << std::strerror (errno));
+        }
+
+      std::map<pid_t, std::pair<uint32_t, int> >::iterator c = children.find (pid);
+      if (c == children.end ())
+        continue;
+
+      uint32_t variant = c->second.first;
+      bool complete = ReadAll (c->second.second, &results[variant], sizeof (SimulationResults));
+      close (c->second.second);
+      children.erase (c);
+
+      if (!WIFEXITED (status) || (WEXITSTATUS (status) != 0) || !complete)
+        NS_FATAL_ERROR ("variant " << params.variants[variant].name << " failed");
+    }
+
+  fd = -1;
+  return -1;
+}
+
+//apply the changes of a variant to the running simulation (validated by ParseVariantFile): Mac-relative attribute
+//paths, cbsa<TID> - idleSlope of a CBSA controller set up in the base scenario, and TIDs switched off
+void
+SimulationHelper::ApplyVariant (NodeContainer nodes, const VariantSpec &variant)
+{
+  static const char *names[6] = { "A_VO", "VO", "VI", "A_VI", "BE", "BK" };
+
+  for (uint32_t c = 0; c < variant.changes.size (); c++)
+    {
+      const std::string &key = variant.changes[c].first;
+      const std::string &value = variant.changes[c].second;
+      bool cbsa = (key.compare (0, 4, "cbsa") == 0);
+      int16_t off = -1; //TID switched off
+      for (uint8_t t = 0; t < 6; t++)
+        if (key == names[t])
+          off = QUEUE_TIDS[t];
+
+      for (NodeContainer::Iterator n = nodes.Begin (); n != nodes.End (); ++n)
+        {
+          Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> ((*n)->GetDevice (0));
+          NS_ASSERT (device != 0);
+
+          if (key.find ('/') != std::string::npos) //e.g. VI_Txop/TxopLimit
+            SetMacAttribute (device, key, value);
+          else if (cbsa)
+            {
+              Ptr<Object> controller = GetQueueController (device, key[4] - '0');
+              if (controller == 0)
+                NS_FATAL_ERROR ("variant " << variant.name << ": no CBSA controller for TID " << key[4]
+                                << " - set " << key << " in the base scenario");
+              controller->SetAttribute ("IdleSlope", DataRateValue (DataRate (value)));
+            }
+          else if (off >= 0) //stop the sources of the TID, their sinks stay
+            for (uint32_t a = 0; a < (*n)->GetNApplications (); a++)
+              {
+                Ptr<Application> app = (*n)->GetApplication (a);
+                Ptr<SaturatedMacSource> macSource = DynamicCast<SaturatedMacSource> (app);
+                Ptr<BackpressureSource> backpressure = DynamicCast<BackpressureSource> (app);
+                Ptr<OnOffApplication> onOff = DynamicCast<OnOffApplication> (app);
+                if ((macSource != 0) && (macSource->GetTid () == off))
+                  macSource->Stop ();
+                else if ((backpressure != 0) && (backpressure->GetTid () == off))
+                  backpressure->Stop ();
+                else if (onOff != 0)
+                  {
+                    AddressValue remote;
+                    onOff->GetAttribute ("Remote", remote);
+                    if (InetSocketAddress::IsMatchingType (remote.Get ())
+                        && (InetSocketAddress::ConvertFrom (remote.Get ()).GetPort () == 1000 + off))
+                      onOff->SetAttribute ("MaxBytes", UintegerValue (1)); //stops after the packet already scheduled
+                  }
+              }
+        }
+    }
+}
+
+
+
+/* ===== analytical EDCA model ===== */
+
+//Bianchi-style saturation model extended to the four EDCA functions of AltEDCA: per-AC backoff chain with
+//retry limit, AIFS differentiation by slot zones after each busy period (only ACs whose AIFS has elapsed
+//contend), internal collisions won by the higher AC, TXOP bursts; 802.11a timing with the DataMode/ControlMode
+//of the scenario (OfdmRate54Mbps / OfdmRate6Mbps)
+AnalyticResults
+SimulationHelper::AnalyticModel (const SimulationParameters &params)
+{
+  //EDCA defaults of the MAC for OFDM PHYs, overridden by <AC>_Txop/<attribute> scenario keys
+  static const char *names[4] = { "VO_Txop", "VI_Txop", "BE_Txop", "BK_Txop" }; //highest priority first
+  uint32_t minCw[4] = { 3, 7, 15, 15 };
+  uint32_t maxCw[4] = { 7, 15, 1023, 1023 };
+  uint32_t aifsn[4] = { 2, 2, 3, 7 };
+  double txopLimit[4] = { 1504, 3008, 0, 0 }; //[us]
+  const uint8_t hiTid[4] = { 7, 5, 0, 1 };
+  const uint8_t lowTid[4] = { 6, 4, 0, 1 };
+  const bool hiEnabled[4] = { params.A_VO, params.VI, params.BE, params.BK };
+  const bool lowEnabled[4] = { params.VO, params.A_VI, params.BE, params.BK };
+
+  for (uint32_t o = 0; o < params.configOverrides.size (); o++)
+    for (uint8_t ac = 0; ac < 4; ac++)
+      {
+        const std::string &key = params.configOverrides[o].first;
+        const std::string &value = params.configOverrides[o].second;
+        if (key == std::string (names[ac]) + "/MinCw")
+          minCw[ac] = std::atoi (value.c_str ());
+        else if (key == std::string (names[ac]) + "/MaxCw")
+          maxCw[ac] = std::atoi (value.c_str ());
+        else if (key == std::string (names[ac]) + "/Aifsn")
+          aifsn[ac] = std::atoi (value.c_str ());
+        else if (key == std::string (names[ac]) + "/TxopLimit")
+          txopLimit[ac] = Time (value).GetMicroSeconds ();
+      }
+
+  //802.11a timing [us]
+  const double slot = 9, sifs = 16;
+  const uint32_t ipSize = params.packetSize + 28;
+  const uint32_t mpdu = 26 + 8 + ipSize + 4; //QoS MAC header, LLC/SNAP, IP packet, FCS
+  struct Ofdm
+  {
+    static double Duration (uint32_t bytes, double mbps) //preamble + SIGNAL, SERVICE and tail bits
+    {
+      return 20 + 4 * std::ceil ((16 + 6 + 8.0 * bytes) / (4 * mbps));
+    }
+  };
+  const double data = Ofdm::Duration (mpdu, 54), ack = Ofdm::Duration (14, 6);
+  const double rts = Ofdm::Duration (20, 6), cts = Ofdm::Duration (14, 6);
+  const double rtsCts = params.rtsCts ? rts + sifs + cts + sifs : 0;
+
+  bool enabled[4];
+  uint32_t aifsnMin = 255;
+  for (uint8_t ac = 0; ac < 4; ac++)
+    {
+      enabled[ac] = hiEnabled[ac] || lowEnabled[ac];
+      if (enabled[ac])
+        aifsnMin = std::min (aifsnMin, aifsn[ac]);
+    }
+
+  const double aifsMin = sifs + aifsnMin * slot;
+  double busySuccess[4], frames[4];
+  for (uint8_t ac = 0; ac < 4; ac++)
+    {
+      frames[ac] = 1;
+      if (txopLimit[ac] > 0)
+        frames[ac] = std::max (1.0, std::floor ((txopLimit[ac] - rtsCts + sifs) / (data + sifs + ack + sifs)));
+      busySuccess[ac] = rtsCts + frames[ac] * (data + sifs + ack) + (frames[ac] - 1) * sifs + aifsMin;
+    }
+  const double busyCollision = params.rtsCts ? rts + sifs + cts + aifsMin : data + sifs + ack + aifsMin;
+
+  //slot zones after a busy period: AC may contend from slot (aifsn - aifsnMin) on
+  uint32_t zone[4], lastZone = 0;
+  for (uint8_t ac = 0; ac < 4; ac++)
+    {
+      zone[ac] = enabled[ac] ? aifsn[ac] - aifsnMin : 0;
+      if (enabled[ac])
+        lastZone = std::max (lastZone, zone[ac]);
+    }
+
+  //transmissions per frame: MaxSlrc for an MPDU longer than RtsCtsThreshold (0 with RTSCTS, 2500 otherwise - as set in
+  //RunSimulation), MaxSsrc for a shorter one; attribute defaults of the station manager (incl. Config::SetDefault)
+  TypeId::AttributeInformation retry;
+  TypeId::LookupByName ("ns3::WifiRemoteStationManager").LookupAttributeByName ((mpdu > (params.rtsCts ? 0u : 2500u)) ? "MaxSlrc" : "MaxSsrc", &retry);
+  const uint32_t retryLimit = std::max<uint64_t> (DynamicCast<const UintegerValue> (retry.initialValue)->Get (), 1);
+
+  const double n = params.nSTA;
+  double tau[4] = { 0.1, 0.1, 0.1, 0.1 }, p[4] = { 0, 0, 0, 0 };
+  std::vector<double> pi (lastZone + 1), quiet (lastZone + 1);
+
+  for (uint32_t iteration = 0; iteration < 10000; iteration++)
+    {
+      //probability that a station stays silent in a slot of zone s, stationary slot distribution
+      for (uint32_t z = 0; z <= lastZone; z++)
+        {
+          quiet[z] = 1;
+          for (uint8_t ac = 0; ac < 4; ac++)
+            if (enabled[ac] && (zone[ac] <= z))
+              quiet[z] *= 1 - tau[ac];
+        }
+      pi[0] = 1;
+      for (uint32_t z = 1; z <= lastZone; z++)
+        pi[z] = pi[z - 1] * std::pow (quiet[z - 1], n);
+      if (lastZone > 0)
+        pi[lastZone] /= 1 - std::pow (quiet[lastZone], n);
+      double sum = 0;
+      for (uint32_t z = 0; z <= lastZone; z++)
+        sum += pi[z];
+      for (uint32_t z = 0; z <= lastZone; z++)
+        pi[z] /= sum;
+
+      double change = 0;
+      for (uint8_t ac = 0; ac < 4; ac++)
+        {
+          if (!enabled[ac])
+            continue;
+
+          //collision probability seen by an attempt: other stations or a higher AC of the same station
+          double eligible = 0, clear = 0;
+          for (uint32_t z = zone[ac]; z <= lastZone; z++)
+            {
+              double higher = 1;
+              for (uint8_t h = 0; h < ac; h++)
+                if (enabled[h] && (zone[h] <= z))
+                  higher *= 1 - tau[h];
+              eligible += pi[z];
+              clear += pi[z] * higher * std::pow (quiet[z], n - 1);
+            }
+          p[ac] = 1 - clear / eligible;
+
+          //attempts per backoff slot of a saturated AC (renewal over one frame)
+          double attempts = 0, backoff = 0, stage = 1;
+          uint32_t cw = minCw[ac];
+          for (uint32_t r = 0; r < retryLimit; r++)
+            {
+              attempts += stage;
+              backoff += stage * cw / 2.0;
+              stage *= p[ac];
+              cw = std::min (2 * cw + 1, maxCw[ac]);
+            }
+          double next = attempts / (attempts + backoff);
+          change = std::max (change, std::abs (next - tau[ac]));
+          tau[ac] = 0.5 * tau[ac] + 0.5 * next;
+        }
+      if (change < 1e-12)
+        break;
+    }
+
+  //per-slot success probabilities and mean slot duration
+  double success[4] = { 0, 0, 0, 0 }, slotTime = 0;
+  for (uint32_t z = 0; z <= lastZone; z++)
+    {
+      double idle = std::pow (quiet[z], n), busy = 1 - idle;
+      double duration = idle * slot;
+      for (uint8_t ac = 0; ac < 4; ac++)
+        {
+          if (!enabled[ac] || (zone[ac] > z))
+            continue;
+          double higher = 1;
+          for (uint8_t h = 0; h < ac; h++)
+            if (enabled[h] && (zone[h] <= z))
+              higher *= 1 - tau[h];
+          double ps = n * tau[ac] * higher * std::pow (quiet[z], n - 1);
+          success[ac] += pi[z] * ps;
+          duration += ps * busySuccess[ac];
+          busy -= ps;
+        }
+      slotTime += pi[z] * (duration + busy * busyCollision);
+    }
+
+  AnalyticResults model;
+  std::memset (&model, 0, sizeof (model));
+  for (uint8_t ac = 0; ac < 4; ac++)
+    {
+      if (!enabled[ac])
+        continue;
+      double throughput = success[ac] * frames[ac] * ipSize * 8 / slotTime; //[Mb/s]
+      uint8_t tid = hiEnabled[ac] ? hiTid[ac] : lowTid[ac]; //the low TID of a Txop is served only when the high one is empty
+      model.throughput[tid] = throughput;
+      model.accessDelay[tid] = (throughput > 0) ? n * ipSize * 8 / throughput / 1000 : 0;
+    }
+  return model;
+}
+
+//model results per TID, compared with the simulated throughput if given
+void
+SimulationHelper::PrintAnalytic (const AnalyticResults &model, const SimulationParameters &params, const SimulationResults *simulated)
+{
+  const bool enabled[6] = { params.A_VO, params.VO, params.VI, params.A_VI, params.BE, params.BK };
+  double offered = params.Mbps * (params.packetSize + 28) / params.packetSize; //per station and TID, IP level [Mb/s]
+
+  if (!params.cbsaIdleSlope.empty ())
+    std::cout << "(analytic model: CBSA is not modelled - strict priority between the TIDs of one Txop assumed)" << std::endl;
+
+  for (uint8_t t = 0; t < 6; t++)
+    {
+      if (!enabled[t])
+        continue;
+      uint8_t tid = QUEUE_TIDS[t];
+
+      std::cout << "=======================TID: " << (uint16_t) tid << " (analytic) =============================" << std::endl;
+      std::cout << "  Analytic throughput:\t" << model.throughput[tid] << " Mb/s" << std::endl;
+      if (model.throughput[tid] > 0)
+        std::cout << "  Analytic access delay:\t" << model.accessDelay[tid] << " ms" << std::endl;
+      else
+        std::cout << "  Analytic access delay:\t---" << std::endl;
+      if (params.nSTA * offered < model.throughput[tid]) //sources cannot saturate this AC
+        std::cout << "  Analytic note:\tnot saturated (offered " << params.nSTA * offered << " Mb/s)" << std::endl;
+
+      if (simulated == 0)
+        continue;
+      double measured = simulated->tid[tid].throughput;
+      std::cout << "  Simulated throughput:\t" << measured << " Mb/s" << std::endl;
+      if (measured > 0)
+        std::cout << "  Relative error:\t" << 100 * (model.throughput[tid] - measured) / measured << " %" << std::endl;
+      else
+        std::cout << "  Relative error:\t---" << std::endl;
+    }
+}
+
+
+
+/* ===== path loss cache ===== */
+
+//wrap the loss models of the channel up to the first stochastic one in a CachedPropagationLossModel
+void
+SimulationHelper::InstallLossCache (Ptr<YansWifiChannel> channel)
+{
+  static const char *stochastic[] = { "ns3::NakagamiPropagationLossModel", "ns3::JakesPropagationLossModel",
+                                      "ns3::RandomPropagationLossModel" };
+
+  PointerValue ptr;
+  channel->GetAttribute ("PropagationLossModel", ptr);
+  Ptr<PropagationLossModel> first = ptr.Get<PropagationLossModel> ();
+
+  Ptr<PropagationLossModel> last, model;
+  for (model = first; model != 0; model = model->GetNext ())
+    {
+      bool random = false;
+      for (uint8_t m = 0; m < 3; m++)
+        random = random || (model->GetInstanceTypeId ().GetName () == stochastic[m]);
+      if (random)
+        break;
+      last = model;
+    }
+  if (last == 0) //first model already stochastic - nothing to cache
+    return;
+
+  last->SetNext (0);
+  Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+  cached->SetModel (first);
+  if (model != 0)
+    cached->SetNext (model);
+  channel->SetPropagationLossModel (cached);
+}
+
+
+
+/* ===== binary packet event trace ===== */
+
+/*
+ * Fixed-size records in a memory-mapped ring file (decoded with wifi_jows_events.py) - a cheap replacement
+ * for the ASCII traces: one 32 B store per event, no formatting, flushed by the kernel.
+ * All values are little-endian:
+ *
+ *   header (64 B):   "WJEV", u16 version, u16 record size, u32 capacity (records), u32 reserved,
+ *                    u64 written (records since the start - the ring holds the last min (written, capacity)),
+ *                    40 B reserved
+ *   record (32 B):   i64 time [ns], u64 packet UID, u32 node, u32 size [B], u16 sequence number,
+ *                    u8 TID, u8 queue (0 - Queue of BE/BK, 1 - HiTidQueue, 2 - LowTidQueue), u8 event, 3 B reserved
+ *
+ * Events: ENQUEUE/DEQUEUE/DROP - AltEDCA queues; TX - PhyTxBegin of a QoS data frame (every attempt);
+ * ACK - TxOkHeader of the transmitter (UID 0, matched with TX by node, TID and sequence number);
+ * RX - MacRx of the receiver
+ */
+class EventTracer
+{
+public:
+  enum Event { ENQUEUE = 0, DEQUEUE = 1, DROP = 2, TX = 3, ACK = 4, RX = 5 };
+
+  EventTracer ();
+  ~EventTracer ();
+
+  void Open (std::string fileName, uint32_t capacity);
+  void Connect (NetDeviceContainer devices);
+  void Close (void);
+  uint64_t GetWritten (void) const;
+
+private:
+  struct Header
+  {
+    char magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    uint32_t reserved;
+    uint64_t written;
+    uint8_t padding[40];
+  };
+
+  struct Record
+  {
+    int64_t time;
+    uint64_t uid;
+    uint32_t node;
+    uint32_t size;
+    uint16_t sequence;
+    uint8_t tid;
+    uint8_t queue;
+    uint8_t event;
+    uint8_t reserved[3];
+  };
+
+  //trace source of one queue or device - bound to the callbacks
+  struct Source
+  {
+    EventTracer *tracer;
+    uint32_t node;
+    uint8_t tid;   //TID of the queue (frames without a QoS header)
+    uint8_t queue;
+  };
+
+  static uint8_t QueueOf (uint8_t tid);
+
+  void Write (const Source *source, uint8_t event, uint8_t tid, uint64_t uid, uint32_t size, uint16_t sequence);
+
+  static void NotifyEnqueue (Source *source, Ptr<const WifiMacQueueItem> item);
+  static void NotifyDequeue (Source *source, Ptr<const WifiMacQueueItem> item);
+  static void NotifyDrop (Source *source, Ptr<const WifiMacQueueItem> item);
+  static void NotifyQueue (Source *source, uint8_t event, Ptr<const WifiMacQueueItem> item);
+  static void NotifyTx (Source *source, Ptr<const Packet> packet, double txPowerW);
+  static void NotifyAck (Source *source, const WifiMacHeader &header);
+  static void NotifyRx (Source *source, Ptr<const Packet> packet);
+
+  int m_fd;
+  Header *m_header;
+  Record *m_records;
+  uint32_t m_capacity;
+  size_t m_mapped;
+  std::deque<Source> m_sources; //bound to the trace callbacks by address - a deque keeps them valid while growing
+};
+
+EventTracer::EventTracer ()
+  : m_fd (-1),
+    m_header (0),
+    m_records (0),
+    m_capacity (0),
+    m_mapped (0)
+{
+}
+
+EventTracer::~EventTracer ()
+{
+  Close ();
+}
+
+//create the ring file (sparse - only the written part takes disk space) and map it
+void
+EventTracer::Open (std::string fileName, uint32_t capacity)
+{
+  NS_ASSERT (sizeof (Header) == 64 && sizeof (Record) == 32);
+  if (capacity == 0)
+    NS_FATAL_ERROR ("eventTraceRecords must be positive");
+
+  m_fd = open (fileName.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (m_fd < 0)
+    NS_FATAL_ERROR ("cannot open event trace " << fileName << ": " << std::strerror (errno));
+  m_mapped = sizeof (Header) + (size_t) capacity * sizeof (Record);
+  if (ftruncate (m_fd, m_mapped) != 0)
+    NS_FATAL_ERROR ("cannot size event trace " << fileName << ": " << std::strerror (errno));
+  void *map = mmap (0, m_mapped, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED)
+    NS_FATAL_ERROR ("cannot map event trace " << fileName << ": " << std::strerror (errno));
+
+  m_header = static_cast<Header *> (map);
+  m_records = reinterpret_cast<Record *> (m_header + 1);
+  m_capacity = capacity;
+  std::memcpy (m_header->magic, "WJEV", 4);
+  m_header->version = 1;
+  m_header->recordSize = sizeof (Record);
+  m_header->capacity = capacity;
+  m_header->written = 0;
+}
+
+//hook the six AltEDCA queues, the PHY and the MAC of every device
+void
+EventTracer::Connect (NetDeviceContainer devices)
+{
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (*i);
+      uint32_t node = device->GetNode ()->GetId ();
+
+      for (uint8_t q = 0; q < 6; q++)
+        {
+          Source source = { this, node, QUEUE_TIDS[q], QueueOf (QUEUE_TIDS[q]) };
+          m_sources.push_back (source);
+          Ptr<WifiMacQueue> queue = SimulationHelper::GetTidQueue (device, QUEUE_TIDS[q]);
+          queue->TraceConnectWithoutContext ("Enqueue", MakeBoundCallback (&EventTracer::NotifyEnqueue, &m_sources.back ()));
+          queue->TraceConnectWithoutContext ("Dequeue", MakeBoundCallback (&EventTracer::NotifyDequeue, &m_sources.back ()));
+          queue->TraceConnectWithoutContext ("Drop",    MakeBoundCallback (&EventTracer::NotifyDrop, &m_sources.back ()));
+          queue->TraceConnectWithoutContext ("Expired", MakeBoundCallback (&EventTracer::NotifyDrop, &m_sources.back ())); //lifetime (MaxDelay) exceeded
+        }
+
+      Source source = { this, node, 0, 0 };
+      m_sources.push_back (source);
+      device->GetPhy ()->TraceConnectWithoutContext ("PhyTxBegin", MakeBoundCallback (&EventTracer::NotifyTx, &m_sources.back ()));
+      device->GetMac ()->TraceConnectWithoutContext ("MacRx", MakeBoundCallback (&EventTracer::NotifyRx, &m_sources.back ()));
+      if (!device->GetMac ()->TraceConnectWithoutContext ("TxOkHeader", MakeBoundCallback (&EventTracer::NotifyAck, &m_sources.back ())))
+        NS_LOG_WARN ("no TxOkHeader trace - ACK events not recorded (RX of the receiver still is)");
+    }
+}
+
+void
+EventTracer::Close (void)
+{
+  if (m_header == 0)
+    return;
+  msync (m_header, m_mapped, MS_ASYNC);
+  munmap (m_header, m_mapped);
+  close (m_fd);
+  m_header = 0;
+  m_records = 0;
+  m_fd = -1;
+}
+
+uint64_t
+EventTracer::GetWritten (void) const
+{
+  return (m_header != 0) ? m_header->written : 0;
+}
+
+uint8_t
+EventTracer::QueueOf (uint8_t tid)
+{
+  static const uint8_t queues[8] = { 0, 0, 0, 0, 2, 1, 2, 1 };
+  return queues[tid & 7];
+}
+
+void
+EventTracer::Write (const Source *source, uint8_t event, uint8_t tid, uint64_t uid, uint32_t size, uint16_t sequence)
+{
+  Record &r = m_records[m_header->written % m_capacity];
+  r.time = Simulator::Now ().GetNanoSeconds ();
+  r.uid = uid;
+  r.node = source->node;
+  r.size = size;
+  r.sequence = sequence;
+  r.tid = tid;
+  r.queue = QueueOf (tid);
+  r.event = event;
+  m_header->written++;
+}
+
+void
+EventTracer::NotifyQueue (Source *source, uint8_t event, Ptr<const WifiMacQueueItem> item)
+{
+  const WifiMacHeader &header = item->GetHeader ();
+  uint8_t tid = header.IsQosData () ? header.GetQosTid () : source->tid;
+  source->tracer->Write (source, event, tid, item->GetPacket ()->GetUid (), item->GetPacketSize (), 0);
+}
+
+void
+EventTracer::NotifyEnqueue (Source *source, Ptr<const WifiMacQueueItem> item)
+{
+  NotifyQueue (source, ENQUEUE, item);
+}
+
+void
+EventTracer::NotifyDequeue (Source *source, Ptr<const WifiMacQueueItem> item)
+{
+  NotifyQueue (source, DEQUEUE, item);
+}
+
+void
+EventTracer::NotifyDrop (Source *source, Ptr<const WifiMacQueueItem> item)
+{
+  NotifyQueue (source, DROP, item);
+}
+
+//every transmission attempt of a QoS data frame (control frames and ACKs are skipped)
+void
+EventTracer::NotifyTx (Source *source, Ptr<const Packet> packet, double txPowerW)
+{
+  WifiMacHeader header;
+  packet->PeekHeader (header);
+  if (!header.IsQosData ())
+    return;
+  source->tracer->Write (source, TX, header.GetQosTid (), packet->GetUid (), packet->GetSize (), header.GetSequenceNumber ());
+}
+
+void
+EventTracer::NotifyAck (Source *source, const WifiMacHeader &header)
+{
+  if (!header.IsQosData ())
+    return;
+  source->tracer->Write (source, ACK, header.GetQosTid (), 0, 0, header.GetSequenceNumber ());
+}
+
+void
+EventTracer::NotifyRx (Source *source, Ptr<const Packet> packet)
+{
+  TidTimestampTag tag;
+  uint8_t tid = packet->PeekPacketTag (tag) ? tag.m_tid : 0;
+  source->tracer->Write (source, RX, tid, packet->GetUid (), packet->GetSize (), 0);
+}
+
+
+
+/* ===== queue occupancy ===== */
+
+//peak and time-averaged occupancy of the six AltEDCA queues of every node, from their PacketsInQueue and
+//BytesInQueue traces (queueStats=1) - for sizing MaxSize, which is 10000p everywhere.
+//ns-3 keeps no count of live Packet objects; in saturated runs they are held almost entirely by these
+//queues, so the sum over all queues and its high-water mark stand for the live packets and bytes
+class QueueOccupancy
+{
+public:
+  static const uint8_t QUEUES = 6;
+
+  QueueOccupancy (Time calcStart);
+
+  void Connect (NetDeviceContainer devices);
+  void StartSampling (std::string fileName, Time period);
+  void Fill (SimulationResults &results, Time calcStop);
+  void PrintNodes (Time calcStop);
+
+  static const char *GetName (uint8_t queue);
+
+private:
+  //one queue of one node - bound to its trace callbacks
+  struct Queue
+  {
+    QueueOccupancy *owner;
+    uint32_t node;
+    uint8_t index;    //0..5 in the order of QUEUE_TIDS
+    uint32_t packets;
+    uint32_t bytes;
+    uint32_t peak;    //[packets] over the whole run, incl. warm-up
+    double area;      //[packet seconds] since calcStart
+    Time last;        //time of the last change
+  };
+
+  static void PacketsChanged (Queue *queue, uint32_t oldValue, uint32_t newValue);
+  static void BytesChanged (Queue *queue, uint32_t oldValue, uint32_t newValue);
+  void Advance (Queue &queue, Time now);
+  double GetAverage (Queue &queue, Time calcStop);
+  void Sample (void);
+
+  Time m_calcStart;
+  std::deque<Queue> m_queues; //bound to the trace callbacks by address (as EventTracer::m_sources)
+  uint64_t m_packets;         //all queues together
+  uint64_t m_bytes;
+  uint64_t m_peakPackets;
+  uint64_t m_peakBytes;
+
+  std::ofstream m_samples;
+  Time m_period;
+};
+
+QueueOccupancy::QueueOccupancy (Time calcStart)
+  : m_calcStart (calcStart),
+    m_packets (0),
+    m_bytes (0),
+    m_peakPackets (0),
+    m_peakBytes (0)
+{
+}
+
+const char *
+QueueOccupancy::GetName (uint8_t queue)
+{
+  static const char *names[QUEUES] = { "VO_Txop/HiTidQueue (A_VO)", "VO_Txop/LowTidQueue (VO)", "VI_Txop/HiTidQueue (VI)",
+                                       "VI_Txop/LowTidQueue (A_VI)", "BE_Txop/Queue (BE)", "BK_Txop/Queue (BK)" };
+  return names[queue];
+}
+
+void
+QueueOccupancy::Connect (NetDeviceContainer devices)
+{
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (*i);
+      for (uint8_t q = 0; q < QUEUES; q++)
+        {
+          Queue queue = { this, device->GetNode ()->GetId (), q, 0, 0, 0, 0, Seconds (0) };
+          m_queues.push_back (queue);
+          Ptr<WifiMacQueue> macQueue = SimulationHelper::GetTidQueue (device, QUEUE_TIDS[q]);
+          macQueue->TraceConnectWithoutContext ("PacketsInQueue", MakeBoundCallback (&QueueOccupancy::PacketsChanged, &m_queues.back ()));
+          macQueue->TraceConnectWithoutContext ("BytesInQueue", MakeBoundCallback (&QueueOccupancy::BytesChanged, &m_queues.back ()));
+        }
+    }
+}
+
+//CSV time series of the occupancy summed over all nodes (a row per period)
+void
+QueueOccupancy::StartSampling (std::string fileName, Time period)
+{
+  m_samples.open (fileName.c_str ());
+  if (!m_samples)
+    NS_FATAL_ERROR ("cannot write " << fileName);
+  m_samples << "time,packets,bytes";
+  for (uint8_t q = 0; q < QUEUES; q++)
+    m_samples << ",tid" << (uint32_t) QUEUE_TIDS[q];
+  m_samples << std::endl;
+  m_period = period;
+  Simulator::Schedule (period, &QueueOccupancy::Sample, this);
+}
+
+void
+QueueOccupancy::Sample (void)
+{
+  uint64_t packets[QUEUES] = { 0 };
+  for (std::deque<Queue>::const_iterator i = m_queues.begin (); i != m_queues.end (); ++i)
+    packets[i->index] += i->packets;
+
+  m_samples << Simulator::Now ().GetSeconds () << "," << m_packets << "," << m_bytes;
+  for (uint8_t q = 0; q < QUEUES; q++)
+    m_samples << "," << packets[q];
+  m_samples << "\n";
+  Simulator::Schedule (m_period, &QueueOccupancy::Sample, this);
+}
+
+//integrate the occupancy held since the last change (only the part after calcStart)
+void
+QueueOccupancy::Advance (Queue &queue, Time now)
+{
+  Time from = std::max (queue.last, m_calcStart);
+  if (now > from)
+    queue.area += queue.packets * (now - from).GetSeconds ();
+  queue.last = now;
+}
+
+void
+QueueOccupancy::PacketsChanged (Queue *queue, uint32_t oldValue, uint32_t newValue)
+{
+  QueueOccupancy *owner = queue->owner;
+  owner->Advance (*queue, Simulator::Now ());
+  queue->packets = newValue;
+  queue->peak = std::max (queue->peak, newValue);
+  owner->m_packets += newValue;
+  owner->m_packets -= oldValue;
+  owner->m_peakPackets = std::max (owner->m_peakPackets, owner->m_packets);
+}
+
+void
+QueueOccupancy::BytesChanged (Queue *queue, uint32_t oldValue, uint32_t newValue)
+{
+  QueueOccupancy *owner = queue->owner;
+  queue->bytes = newValue;
+  owner->m_bytes += newValue;
+  owner->m_bytes -= oldValue;
+  owner->m_peakBytes = std::max (owner->m_peakBytes, owner->m_bytes);
+}
+
+//mean occupancy [packets] between calcStart and calcStop
+double
+QueueOccupancy::GetAverage (Queue &queue, Time calcStop)
+{
+  Advance (queue, calcStop);
+  return (calcStop > m_calcStart) ? queue.area / (calcStop - m_calcStart).GetSeconds () : 0;
+}
+
+//per queue the largest peak and the mean and largest average over the nodes
+void
+QueueOccupancy::Fill (SimulationResults &results, Time calcStop)
+{
+  uint32_t nodes[QUEUES] = { 0 };
+  for (std::deque<Queue>::iterator i = m_queues.begin (); i != m_queues.end (); ++i)
+    {
+      QueueResults &r = results.queue[i->index];
+      double average = GetAverage (*i, calcStop);
+      if ((i->peak > r.peak) || (nodes[i->index] == 0))
+        {
+          r.peak = i->peak;
+          r.peakNode = i->node;
+        }
+      r.meanAverage += average;
+      r.maxAverage = std::max (r.maxAverage, average);
+      nodes[i->index]++;
+    }
+  for (uint8_t q = 0; q < QUEUES; q++)
+    if (nodes[q] > 0)
+      results.queue[q].meanAverage /= nodes[q];
+
+  results.queueStats = true;
+  results.queuedPeakPackets = m_peakPackets;
+  results.queuedPeakBytes = m_peakBytes;
+}
+
+//peak / average of every queue of every node
+void
+QueueOccupancy::PrintNodes (Time calcStop)
+{
+  std::cout << "=======================Queues per node: (peak / average [packets]) ====" << std::endl;
+  std::cout << "  Node";
+  for (uint8_t q = 0; q < QUEUES; q++)
+    std::cout << "\ttid" << (uint32_t) QUEUE_TIDS[q];
+  std::cout << std::endl;
+  for (std::deque<Queue>::iterator i = m_queues.begin (); i != m_queues.end (); ++i)
+    {
+      if (i->index == 0)
+        std::cout << "  " << i->node;
+      std::cout << "\t" << i->peak << " / " << GetAverage (*i, calcStop);
+      if (i->index == QUEUES - 1)
+        std::cout << std::endl;
+    }
+}
+
+
+
+/* ===== scenario files ===== */
+
+//set one scenario value given by its command line name, a Mac-relative attribute path or cbsa<TID>
+bool
+SimulationHelper::SetParameter (SimulationParameters &params, std::string key, std::string value)
+{
+  std::istringstream in (value);
+  bool flag = (value == "1") || (value == "true") || (value == "True");
+
+  if (key.find ('/') != std::string::npos) //e.g. VO_Txop/MinCw or BE_Txop/Queue/MaxDelay
+    {
+      params.configOverrides.push_back (std::make_pair (key, value));
+      return true;
+    }
+  if ((key.size () == 5) && (key.compare (0, 4, "cbsa") == 0) && (key[4] >= '0') && (key[4] <= '7'))
+    {
+      if (value.find_first_not_of ("0123456789") == std::string::npos)
+        value += "bps";
+      params.cbsaIdleSlope[key[4] - '0'] = DataRate (value);
+      return true;
+    }
+
+  if      (key == "nSTA")        in >> params.nSTA;
+  else if (key == "packetSize")  in >> params.packetSize;
+  else if (key == "simTime")     in >> params.simTime;
+  else if (key == "calcStart")   in >> params.calcStart;
+  else if (key == "radius")      in >> params.radius;
+  else if (key == "oneDest")     params.oneDest = flag;
+  else if (key == "RTSCTS")      params.rtsCts = flag;
+  else if (key == "A_VO")        params.A_VO = flag;
+  else if (key == "VO")          params.VO = flag;
+  else if (key == "VI")          params.VI = flag;
+  else if (key == "A_VI")        params.A_VI = flag;
+  else if (key == "BE")          params.BE = flag;
+  else if (key == "BK")          params.BK = flag;
+  else if (key == "Mbps")        in >> params.Mbps;
+  else if (key == "seed")        in >> params.seed;
+  else if (key == "flowMonitor") params.flowMonitor = flag;
+  else if (key == "resultsFile") params.resultsFile = value;
+  else if (key == "configPaths") params.configPaths = flag;
+  else if (key == "fast")        params.fast = flag;
+  else if (key == "perfReport")  params.perfReport = flag;
+  else if (key == "macSource")   params.macSource = flag;
+  else if (key == "macSourceDepth") in >> params.macSourceDepth;
+  else if (key == "backpressure") params.backpressure = flag;
+  else if (key == "backpressureThreshold") in >> params.backpressureThreshold;
+  else if (key == "samplePeriod") in >> params.samplePeriod;
+  else if (key == "sampleFile")  params.sampleFile = value;
+  else if (key == "queueStats")  params.queueStats = flag;
+  else if (key == "nBss")        in >> params.nBss;
+  else if (key == "staPerBss")   in >> params.staPerBss;
+  else if (key == "bssChannels") in >> params.bssChannels;
+  else if (key == "queueSampleFile") params.queueSampleFile = value;
+  else if (key == "branchTime")  in >> params.branchTime;
+  else if (key == "ciTarget")    in >> params.ciTarget;
+  else if (key == "gridChannel") params.gridChannel = flag;
+  else if (key == "lossCache")   params.lossCache = flag;
+  else if (key == "staticNodes") params.staticNodes = flag;
+  else if (key == "profile")     in >> params.profile;
+  else if (key == "eventTrace")  params.eventTrace = value;
+  else if (key == "eventTraceRecords") in >> params.eventTraceRecords;
+  else if (key == "pcapFile")    params.pcapFile = value;
+  else if (key == "pcapSample")  params.pcapSample = value;
+  else if (key == "pcapSnapLen") in >> params.pcapSnapLen;
+  else
+    return false;
+
+  return !in.fail ();
+}
+
+static std::string
+Trim (std::string s)
+{
+  size_t first = s.find_first_not_of (" \t\r");
+  if (first == std::string::npos)
+    return "";
+  return s.substr (first, s.find_last_not_of (" \t\r") - first + 1);
+}
+
+/*
+ * INI-like list of parameter sets, each run back to back in one process:
+ *
+ *   # keys before the first section apply to all sets
+ *   simTime = 5
+ *
+ *   [vo-cw3]
+ *   nSTA = 10
+ *   VO_Txop/MinCw = 3                      <- any attribute path relative to /NodeList/x/DeviceList/x/Mac/
+ *   VO_Txop/HiTidQueue/MaxDelay = 10ms
+ *   cbsa7 = 8400000                        <- SetQueueControllerForTid (7, CBSA) with the given idleSlope
+ */
+std::vector<std::pair<std::string, SimulationParameters> >
+SimulationHelper::ParseScenarioFile (std::string fileName, const SimulationParameters &defaults)
+{
+  std::ifstream file (fileName.c_str ());
+  if (!file)
+    NS_FATAL_ERROR ("cannot open scenario file " << fileName);
+
+  std::vector<std::pair<std::string, SimulationParameters> > scenarios;
+  SimulationParameters common = defaults;
+  std::string line;
+  uint32_t lineNumber = 0;
+
+  while (std::getline (file, line))
+    {
+      lineNumber++;
+      line = Trim (line);
+      if (line.empty () || (line[0] == '#') || (line[0] == ';'))
+        continue;
+
+      if (line[0] == '[')
+        {
+          if (line[line.size () - 1] != ']')
+            NS_FATAL_ERROR (fileName << ":" << lineNumber << ": malformed section header");
+          scenarios.push_back (std::make_pair (line.substr (1, line.size () - 2), common));
+          continue;
+        }
+
+      size_t eq = line.find ('=');
+      if (eq == std::string::npos)
+        NS_FATAL_ERROR (fileName << ":" << lineNumber << ": expected key = value");
+      std::string key = Trim (line.substr (0, eq));
+      std::string value = Trim (line.substr (eq + 1));
+
+      SimulationParameters &target = scenarios.empty () ? common : scenarios.back ().second;
+      if (!SetParameter (target, key, value))
+        NS_FATAL_ERROR (fileName << ":" << lineNumber << ": bad parameter " << key << " = " << value);
+    }
+
+  if (scenarios.empty ())
+    scenarios.push_back (std::make_pair (fileName, common));
+
+  return scenarios;
+}
+
+/*
+ * variants continued from branchTime, in the format of the scenario files - one section per variant, with the
+ * changes that can be made to a running simulation:
+ *
+ *   [cbsa-vo]
+ *   cbsa7 = 6000000                        <- new idleSlope of the CBSA controller set up by cbsa7 in the base scenario
+ *
+ *   [no-bk]
+ *   BK = 0                                 <- TID switched off (its sources stop)
+ *
+ *   [vi-txop]
+ *   VI_Txop/TxopLimit = 3008us             <- any attribute path relative to /NodeList/x/DeviceList/x/Mac/
+ *
+ * the unchanged continuation is always run first, as variant "base"
+ */
+std::vector<VariantSpec>
+SimulationHelper::ParseVariantFile (std::string fileName)
+{
+  std::ifstream file (fileName.c_str ());
+  if (!file)
+    NS_FATAL_ERROR ("cannot open variant file " << fileName);
+
+  std::vector<VariantSpec> variants (1);
+  variants[0].name = "base";
+  std::string line;
+  uint32_t lineNumber = 0;
+
+  while (std::getline (file, line))
+    {
+      lineNumber++;
+      line = Trim (line);
+      if (line.empty () || (line[0] == '#') || (line[0] == ';'))
+        continue;
+
+      if (line[0] == '[')
+        {
+          if (line[line.size () - 1] != ']')
+            NS_FATAL_ERROR (fileName << ":" << lineNumber << ": malformed section header");
+          variants.push_back (VariantSpec ());
+          variants.back ().name = line.substr (1, line.size () - 2);
+          continue;
+        }
+
+      size_t eq = line.find ('=');
+      if ((eq == std::string::npos) || (variants.size () == 1))
+        NS_FATAL_ERROR (fileName << ":" << lineNumber << ": expected key = value in a [variant] section");
+      std::string key = Trim (line.substr (0, eq));
+      std::string value = Trim (line.substr (eq + 1));
+
+      bool tid = (key == "A_VO") || (key == "VO") || (key == "VI") || (key == "A_VI") || (key == "BE") || (key == "BK");
+      bool cbsa = (key.size () == 5) && (key.compare (0, 4, "cbsa") == 0) && (key[4] >= '0') && (key[4] <= '7');
+      if (tid && (value != "0") && (value != "false") && (value != "False"))
+        NS_FATAL_ERROR (fileName << ":" << lineNumber << ": " << key << " can only be switched off at the branch time (enable it in the base scenario)");
+      if (!tid && !cbsa && (key.find ('/') == std::string::npos))
+        NS_FATAL_ERROR (fileName << ":" << lineNumber << ": " << key << " cannot be changed at the branch time");
+      if (cbsa && (value.find_first_not_of ("0123456789") == std::string::npos))
+        value += "bps";
+      variants.back ().changes.push_back (std::make_pair (key, value));
+    }
+
+  return variants;
+}
+
+
+
+/* ===== binary results file ===== */
+
+/*
+ * Compact replacement for FlowMonitor::SerializeToXmlFile (read with wifi_jows_results.py).
+ * All values are little-endian:
+ *
+ *   header (80 B):   "WJRS", u16 version (2), u16 header size, u32 nTids, u32 nFlows, u32 seed, u32 run,
+ *                    u32 nSTA, u32 packetSize, f64 simTime, f64 calcStart,
+ *                    f64 delayBinWidth, f64 jitterBinWidth, f64 packetSizeBinWidth,
+ *                    u32 latencyUnit [ns], u32 latencySubBuckets (LatencyHistogram layout)
+ *   nTids x 92 B:    u64 txBytes, rxBytes, txPackets, rxPackets, lostPackets, f64 throughput [Mb/s],
+ *                    i64 delaySum [ns], i64 jitterSum [ns], f64 delayP50, delayP99, delayP999 [ms],
+ *                    u32 nLatencyBins
+ *   nFlows x 140 B:  u32 flowId, srcAddr, dstAddr, u16 srcPort, dstPort, u8 protocol, u8 tid,
+ *                    u16 nDropReasons, u32 txPackets, rxPackets, lostPackets, timesForwarded,
+ *                    u32 nDelayBins, nJitterBins, nSizeBins, u64 txBytes, rxBytes,
+ *                    i64 delaySum, jitterSum, timeFirstTx, timeFirstRx, timeLastTx, timeLastRx [ns],
+ *                    f64 delayP50, delayP99, delayP999 [ms], u32 nLatencyBins
+ *   histograms:      the latency histograms of the TIDs, then per flow, in flow order - the delay, jitter,
+ *                    packet size and latency histograms and the non-zero drop reasons. Only non-empty bins are
+ *                    stored, as LEB128 (index delta, count) pairs, the index delta being taken from the previous
+ *                    non-empty bin (from 0 for the first one); drop reasons as LEB128 (reason, packets, bytes)
+ *
+ * Version 1 files (read by wifi_jows_results.py as well) lack the latency fields.
+ */
+
+static void
+PutBytes (std::vector<uint8_t> &buf, const void *data, size_t size)
+{
+  const uint8_t *p = static_cast<const uint8_t *> (data);
+  buf.insert (buf.end (), p, p + size);
+}
+
+static void
+PutU16 (std::vector<uint8_t> &buf, uint16_t v)
+{
+  for (int i = 0; i < 2; i++)
+    buf.push_back ((v >> (8 * i)) & 0xff);
+}
+
+static void
+PutU32 (std::vector<uint8_t> &buf, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+    buf.push_back ((v >> (8 * i)) & 0xff);
+}
+
+static void
+PutU64 (std::vector<uint8_t> &buf, uint64_t v)
+{
+  for (int i = 0; i < 8; i++)
+    buf.push_back ((v >> (8 * i)) & 0xff);
+}
+
+static void
+PutF64 (std::vector<uint8_t> &buf, double v)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &v, sizeof (bits));
+  PutU64 (buf, bits);
+}
+
+static void
+PutVarint (std::vector<uint8_t> &buf, uint64_t v)
+{
+  while (v >= 0x80)
+    {
+      buf.push_back ((v & 0x7f) | 0x80);
+      v >>= 7;
+    }
+  buf.push_back (v);
+}
+
+//append sparse, delta-encoded bins of a FlowMonitor histogram, return the number of non-empty bins
+static uint32_t
+PutHistogram (std::vector<uint8_t> &buf, Histogram histogram)
+{
+  uint32_t nonEmpty = 0, previous = 0;
+  for (uint32_t i = 0; i < histogram.GetNBins (); i++)
+    {
+      uint32_t count = histogram.GetBinCount (i);
+      if (count == 0)
+        continue;
+      PutVarint (buf, i - previous);
+      PutVarint (buf, count);
+      previous = i;
+      nonEmpty++;
+    }
+  return nonEmpty;
+}
+
+//the same for a latency histogram (0 - no such flow)
+static uint32_t
+PutLatency (std::vector<uint8_t> &buf, const LatencyHistogram *latency)
+{
+  uint32_t nonEmpty = 0, previous = 0;
+  for (uint32_t i = 0; (latency != 0) && (i < LatencyHistogram::BUCKETS); i++)
+    {
+      uint32_t count = latency->GetBucketCount (i);
+      if (count == 0)
+        continue;
+      PutVarint (buf, i - previous);
+      PutVarint (buf, count);
+      previous = i;
+      nonEmpty++;
+    }
+  return nonEmpty;
+}
+
+void
+SimulationHelper::WriteBinaryResults (std::string fileName, const SimulationParameters &params, uint32_t run,
+                                      const SimulationResults &results, const TidStatistics &tidStats,
+                                      Ptr<FlowMonitor> monitor, Ptr<Ipv4FlowClassifier> classifier)
+{
+  std::map< FlowId, FlowMonitor::FlowStats > stats;
+  if (monitor)
+    stats = monitor->GetFlowStats ();
+
+  std::vector<uint8_t> buf;
+  std::vector<uint8_t> histograms;
+
+  DoubleValue delayBinWidth (0), jitterBinWidth (0), packetSizeBinWidth (0);
+  if (monitor)
+    {
+      monitor->GetAttribute ("DelayBinWidth", delayBinWidth);
+      monitor->GetAttribute ("JitterBinWidth", jitterBinWidth);
+      monitor->GetAttribute ("PacketSizeBinWidth", packetSizeBinWidth);
+    }
+
+  PutBytes (buf, "WJRS", 4);
+  PutU16 (buf, 3);  //version
+  PutU16 (buf, 88); //header size
+  PutU32 (buf, 8);
+  PutU32 (buf, stats.size ());
+  PutU32 (buf, params.seed);
+  PutU32 (buf, run);
+  PutU32 (buf, params.nSTA);
+  PutU32 (buf, params.packetSize);
+  PutF64 (buf, params.simTime);
+  PutF64 (buf, params.calcStart);
+  PutF64 (buf, delayBinWidth.Get ());
+  PutF64 (buf, jitterBinWidth.Get ());
+  PutF64 (buf, packetSizeBinWidth.Get ());
+  PutU32 (buf, LatencyHistogram::UNIT);
+  PutU32 (buf, LatencyHistogram::SUB_BUCKETS);
+  PutF64 (buf, results.stopTime); //end of the measured period (before simTime if ciTarget was reached)
+
+  for (uint16_t tid = 0; tid < 8; tid++)
+    {
+      const TidResults &r = results.tid[tid];
+      PutU64 (buf, r.txBytes);
+      PutU64 (buf, r.rxBytes);
+      PutU64 (buf, r.txPackets);
+      PutU64 (buf, r.rxPackets);
+      PutU64 (buf, r.lostPackets);
+      PutF64 (buf, r.throughput);
+      PutU64 (buf, r.delaySum);
+      PutU64 (buf, r.jitterSum);
+      PutF64 (buf, r.delayP50);
+      PutF64 (buf, r.delayP99);
+      PutF64 (buf, r.delayP999);
+      PutU32 (buf, PutLatency (histograms, &tidStats.GetLatency (tid)));
+    }
+
+  for (std::map< FlowId, FlowMonitor::FlowStats >::iterator flow = stats.begin (); flow != stats.end (); flow++)
+    {
+      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (flow->first);
+      const FlowMonitor::FlowStats &f = flow->second;
+
+      uint32_t nDelayBins  = PutHistogram (histograms, f.delayHistogram);
+      uint32_t nJitterBins = PutHistogram (histograms, f.jitterHistogram);
+      uint32_t nSizeBins   = PutHistogram (histograms, f.packetSizeHistogram);
+      const LatencyHistogram *latency = tidStats.GetFlowLatency (t.sourceAddress, t.sourcePort);
+      uint32_t nLatencyBins = PutLatency (histograms, latency);
+      uint16_t nDropReasons = 0;
+      for (uint32_t reason = 0; reason < f.packetsDropped.size (); reason++)
+        if (f.packetsDropped[reason] > 0)
+          {
+            PutVarint (histograms, reason);
+            PutVarint (histograms, f.packetsDropped[reason]);
+            PutVarint (histograms, f.bytesDropped[reason]);
+            nDropReasons++;
+          }
+
+      PutU32 (buf, flow->first);
+      PutU32 (buf, t.sourceAddress.Get ());
+      PutU32 (buf, t.destinationAddress.Get ());
+      PutU16 (buf, t.sourcePort);
+      PutU16 (buf, t.destinationPort);
+      buf.push_back (t.protocol);
+      buf.push_back (t.destinationPort - 1000); //TID
+      PutU16 (buf, nDropReasons);
+      PutU32 (buf, f.txPackets);
+      PutU32 (buf, f.rxPackets);
+      PutU32 (buf, f.lostPackets);
+      PutU32 (buf, f.timesForwarded);
+      PutU32 (buf, nDelayBins);
+      PutU32 (buf, nJitterBins);
+      PutU32 (buf, nSizeBins);
+      PutU64 (buf, f.txBytes);
+      PutU64 (buf, f.rxBytes);
+      PutU64 (buf, f.delaySum.GetNanoSeconds ());
+      PutU64 (buf, f.jitterSum.GetNanoSeconds ());
+      PutU64 (buf, f.timeFirstTxPacket.GetNanoSeconds ());
+      PutU64 (buf, f.timeFirstRxPacket.GetNanoSeconds ());
+      PutU64 (buf, f.timeLastTxPacket.GetNanoSeconds ());
+      PutU64 (buf, f.timeLastRxPacket.GetNanoSeconds ());
+      PutF64 (buf, (latency != 0) ? latency->GetPercentile (0.5) : 0.0);
+      PutF64 (buf, (latency != 0) ? latency->GetPercentile (0.99) : 0.0);
+      PutF64 (buf, (latency != 0) ? latency->GetPercentile (0.999) : 0.0);
+      PutU32 (buf, nLatencyBins);
+    }
+
+  buf.insert (buf.end (), histograms.begin (), histograms.end ());
+
+  std::ofstream out (fileName.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out)
+    NS_FATAL_ERROR ("cannot open results file " << fileName);
+  out.write (reinterpret_cast<const char *> (&buf[0]), buf.size ());
+}
+
+
+
+/* ===== sampled pcap capture ===== */
+
+//radiotap pcap of the transmitted frames (MonitorSnifferTx of every device - each frame once, as seen by a monitor)
+//instead of phy.EnablePcap: QoS data frames sampled deterministically (1 in N per TID, "ctl" - all other frames),
+//every frame cut to the MAC + LLC + IP + UDP headers (or to snapLen) and written in large blocks - by a writer
+//thread (double buffering), so the simulation only waits for the disk if it fills a block before the previous is written
+class SampledPcapWriter
 {
 public:
-	SimulationHelper ();
-	
-	static OnOffHelper CreateOnOffHelper(InetSocketAddress socketAddress, DataRate dataRate, int packetSize, uint8_t tid, Time start, Time stop);
-	static void PopulateArpCache ();
+  SampledPcapWriter ();
+  ~SampledPcapWriter ();
+
+  void Open (std::string fileName, std::string sampling, uint32_t snapLen);
+  void Connect (NetDeviceContainer devices);
+  void Close (void);
+  uint64_t GetSeen (void) const;
+  uint64_t GetCaptured (void) const;
+
+private:
+  static void NotifyTx (SampledPcapWriter *writer, Ptr<const Packet> packet, uint16_t channelFreqMhz,
+                        WifiTxVector txVector, MpduInfo aMpdu, uint16_t staId);
+  void Capture (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector);
+  void Flush (void);
+  void Write (void);
+
+  static const uint32_t BUFFER_SIZE = 1 << 20;
+  static const uint32_t RADIOTAP_SIZE = 22; //TSFT, flags, rate, channel
+
+  std::ofstream m_out;                //written by m_writer only
+  std::vector<uint8_t> m_buffer;      //filled by Capture
+  std::vector<uint8_t> m_pending;     //handed to m_writer (empty - written)
+  std::thread m_writer;
+  std::mutex m_mutex;                 //guards m_pending and m_stop
+  std::condition_variable m_changed;
+  bool m_stop;
+  uint32_t m_every[9];  //per TID, [8] - frames other than QoS data (0 - none)
+  uint64_t m_frames[9];
+  uint32_t m_snapLen;   //0 - headers up to UDP
+  uint64_t m_seen;
+  uint64_t m_captured;
 };
 
-SimulationHelper::SimulationHelper () 
+SampledPcapWriter::SampledPcapWriter ()
+  : m_stop (false),
+    m_snapLen (0),
+    m_seen (0),
+    m_captured (0)
 {
+  for (uint8_t i = 0; i < 9; i++)
+    {
+      m_every[i] = 1;
+      m_frames[i] = 0;
+    }
 }
 
-//prepare CBR traffic source
-OnOffHelper
-SimulationHelper::CreateOnOffHelper(InetSocketAddress socketAddress, DataRate dataRate, int packetSize, uint8_t tid, Time start, Time stop) 
+SampledPcapWriter::~SampledPcapWriter ()
 {
-  socketAddress.SetTos (tid << 5); //(see: https://www.tucny.com/Home/dscp-tos and http://www.revolutionwifi.net/revolutionwifi/2010/08/wireless-qos-part-3-user-priorities.html)
+  Close ();
+}
 
-  OnOffHelper onOffHelper  ("ns3::UdpSocketFactory", socketAddress);
-  onOffHelper.SetAttribute ("OnTime",     StringValue   ("ns3::ConstantRandomVariable[Constant=100000]"));
-  onOffHelper.SetAttribute ("OffTime",    StringValue   ("ns3::ConstantRandomVariable[Constant=0]") );
-  onOffHelper.SetAttribute ("DataRate",   DataRateValue (dataRate) );
-  onOffHelper.SetAttribute ("PacketSize", UintegerValue (packetSize) );
-  //onOffHelper.SetAttribute ("Jitter",     DoubleValue (1.0)); //packets generation times modified by random value between -50% and +50% of constant time step between packets
-  //onOffHelper.SetAttribute ("PoissonTraffic", BooleanValue (true)); //generate packets in Poisson process
-  onOffHelper.SetAttribute ("MaxBytes",   UintegerValue (0));
-  onOffHelper.SetAttribute ("StartTime",  TimeValue (start));
-  onOffHelper.SetAttribute ("StopTime",   TimeValue (stop));
+//sampling: comma-separated N (every TID), TID:N or ctl:N - keep 1 in N frames
+void
+SampledPcapWriter::Open (std::string fileName, std::string sampling, uint32_t snapLen)
+{
+  std::istringstream items (sampling);
+  std::string item;
+  while (std::getline (items, item, ','))
+    {
+      size_t colon = item.find (':');
+      uint32_t every = std::atoi (item.substr (colon + 1).c_str ()); //npos + 1 == 0 - whole item
+      if (colon == std::string::npos)
+        std::fill (m_every, m_every + 9, every);
+      else if (item.substr (0, colon) == "ctl")
+        m_every[8] = every;
+      else
+        {
+          uint32_t tid = std::atoi (item.substr (0, colon).c_str ());
+          if (tid > 7)
+            NS_FATAL_ERROR ("pcapSample: no TID " << tid);
+          m_every[tid] = every;
+        }
+    }
+  m_snapLen = snapLen;
 
-  return onOffHelper;
+  m_out.open (fileName.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_out)
+    NS_FATAL_ERROR ("cannot open pcap file " << fileName);
+  m_buffer.reserve (BUFFER_SIZE + 4096);
+  m_pending.reserve (BUFFER_SIZE + 4096);
+  m_stop = false;
+  m_writer = std::thread (&SampledPcapWriter::Write, this);
+  PutU32 (m_buffer, 0xa1b2c3d4); //magic (microsecond timestamps)
+  PutU16 (m_buffer, 2);          //version 2.4
+  PutU16 (m_buffer, 4);
+  PutU32 (m_buffer, 0);          //GMT
+  PutU32 (m_buffer, 0);          //timestamp accuracy
+  PutU32 (m_buffer, 65535);      //snap length
+  PutU32 (m_buffer, 127);        //DLT_IEEE802_11_RADIO
 }
 
-//fulfill the ARP cache prior to simulation run
 void
-SimulationHelper::PopulateArpCache () 
+SampledPcapWriter::Connect (NetDeviceContainer devices)
 {
-  Ptr<ArpCache> arp = CreateObject<ArpCache> ();
-  arp->SetAliveTimeout (Seconds (3600 * 24 * 365) );
-	
-  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i) 
-    {	
-      Ptr<Ipv4L3Protocol> ip = (*i)->GetObject<Ipv4L3Protocol> ();
-      NS_ASSERT (ip != 0);
-      ObjectVectorValue interfaces;
-      ip->GetAttribute ("InterfaceList", interfaces);
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (*i);
+      device->GetPhy ()->TraceConnectWithoutContext ("MonitorSnifferTx", MakeBoundCallback (&SampledPcapWriter::NotifyTx, this));
+    }
+}
 
-      for (ObjectVectorValue::Iterator j = interfaces.Begin (); j != interfaces.End (); j++) 
-        {		
-          Ptr<Ipv4Interface> ipIface = (*j).second->GetObject<Ipv4Interface> ();
-          NS_ASSERT (ipIface != 0);
-          Ptr<NetDevice> device = ipIface->GetDevice ();
-          NS_ASSERT (device != 0);
-          Mac48Address addr = Mac48Address::ConvertFrom (device->GetAddress () );
-      
-          for (uint32_t k = 0; k < ipIface->GetNAddresses (); k++) 
-            {			
-              Ipv4Address ipAddr = ipIface->GetAddress (k).GetLocal();		
-              if (ipAddr == Ipv4Address::GetLoopback ()) 
-                continue;
+void
+SampledPcapWriter::Close (void)
+{
+  if (!m_out.is_open ())
+    return;
+  Flush ();
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_changed.notify_all ();
+  m_writer.join (); //after the last block
+  m_out.close ();
+}
 
-              ArpCache::Entry *entry = arp->Add (ipAddr);
-              Ipv4Header ipv4Hdr;
-              ipv4Hdr.SetDestination (ipAddr);
-              Ptr<Packet> p = Create<Packet> (100);  
-              entry->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (p, ipv4Hdr) );
-              entry->MarkAlive (addr);
-            }
-        }
-    }
+uint64_t
+SampledPcapWriter::GetSeen (void) const
+{
+  return m_seen;
+}
 
-    for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i) 
-      {
-        Ptr<Ipv4L3Protocol> ip = (*i)->GetObject<Ipv4L3Protocol> ();
-		NS_ASSERT (ip != 0);
-		ObjectVectorValue interfaces;
-		ip->GetAttribute ("InterfaceList", interfaces);
+uint64_t
+SampledPcapWriter::GetCaptured (void) const
+{
+  return m_captured;
+}
 
-        for (ObjectVectorValue::Iterator j = interfaces.Begin (); j != interfaces.End (); j ++)
-          {
-            Ptr<Ipv4Interface> ipIface = (*j).second->GetObject<Ipv4Interface> ();
-            ipIface->SetAttribute ("ArpCache", PointerValue (arp) );
-          }
-      }
+void
+SampledPcapWriter::NotifyTx (SampledPcapWriter *writer, Ptr<const Packet> packet, uint16_t channelFreqMhz,
+                             WifiTxVector txVector, MpduInfo aMpdu, uint16_t staId)
+{
+  writer->Capture (packet, channelFreqMhz, txVector);
 }
 
+void
+SampledPcapWriter::Capture (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector)
+{
+  m_seen++;
+  WifiMacHeader header;
+  packet->PeekHeader (header);
+  uint8_t kind = header.IsQosData () ? header.GetQosTid () : 8;
+  if ((m_every[kind] == 0) || (m_frames[kind]++ % m_every[kind] != 0))
+    return;
 
+  uint32_t size = packet->GetSize (); //incl. FCS
+  uint32_t capture = m_snapLen;
+  if (capture == 0)
+    capture = header.GetSerializedSize () + (header.IsData () ? 8 + 20 + 8 : 0); //LLC/SNAP, IPv4, UDP
+  capture = std::min (capture, size);
 
-/* ===== main function ===== */
+  uint64_t now = Simulator::Now ().GetMicroSeconds ();
+  PutU32 (m_buffer, now / 1000000);
+  PutU32 (m_buffer, now % 1000000);
+  PutU32 (m_buffer, RADIOTAP_SIZE + capture);
+  PutU32 (m_buffer, RADIOTAP_SIZE + size);
 
-int main (int argc, char *argv[])
+  m_buffer.push_back (0); //radiotap version
+  m_buffer.push_back (0);
+  PutU16 (m_buffer, RADIOTAP_SIZE);
+  PutU32 (m_buffer, 0x0000000f); //TSFT, flags, rate, channel
+  PutU64 (m_buffer, now);
+  m_buffer.push_back (0x10);     //FCS at the end
+  m_buffer.push_back (txVector.GetMode ().GetDataRate (txVector.GetChannelWidth ()) / 500000);
+  PutU16 (m_buffer, channelFreqMhz);
+  PutU16 (m_buffer, (channelFreqMhz > 5000) ? 0x0140 : 0x00c0); //OFDM, 5 or 2.4 GHz
+
+  size_t at = m_buffer.size ();
+  m_buffer.resize (at + capture);
+  packet->CopyData (&m_buffer[at], capture);
+  m_captured++;
+
+  if (m_buffer.size () >= BUFFER_SIZE)
+    Flush ();
+}
+
+//hand the filled block to the writer thread (waiting only while it still writes the previous one)
+void
+SampledPcapWriter::Flush (void)
+{
+  if (m_buffer.empty ())
+    return;
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (!m_pending.empty ())
+    m_changed.wait (lock);
+  m_pending.swap (m_buffer); //m_buffer gets the empty, reserved block back
+  lock.unlock ();
+  m_changed.notify_all ();
+}
+
+//writer thread - writes the blocks handed over by Flush until Close
+void
+SampledPcapWriter::Write (void)
 {
-  uint32_t nSTA = 3;
-  uint32_t packetSize = 1470;
-  float simTime = 10;
-  Time appsStart = Seconds(0);
-  float radius = 1.0;
-  float calcStart = 0;
-  bool oneDest = true;
-  bool rtsCts = false;
-  bool A_VO = true;
-  bool VO = true;
-  bool VI = true;
-  bool A_VI = true;
-  bool BE = true;
-  bool BK = true;
-  double Mbps = 54;
-  uint32_t seed = 1;
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      while (m_pending.empty () && !m_stop)
+        m_changed.wait (lock);
+      if (m_pending.empty ()) //stopped, everything written
+        return;
+      lock.unlock ();
+      m_out.write (reinterpret_cast<const char *> (&m_pending[0]), m_pending.size ());
+      lock.lock ();
+      m_pending.clear ();
+      m_changed.notify_all ();
+    }
+}
 
 
-/* ===== Command Line parameters ===== */
 
-  CommandLine cmd;
-  cmd.AddValue ("nSTA",       "Number of stations",                            nSTA);
-  cmd.AddValue ("packetSize", "Packet size [B]",                               packetSize);
-  cmd.AddValue ("simTime",    "simulation time [s]",                           simTime);
-  cmd.AddValue ("calcStart",  "start of results analysis [s]",                 calcStart);
-  cmd.AddValue ("radius",     "Radius of area [m] to randomly place stations", radius);
-  cmd.AddValue ("oneDest",    "use one traffic destination?",                  oneDest);
-  cmd.AddValue ("RTSCTS",     "use RTS/CTS?",                                  rtsCts);
-  cmd.AddValue ("A_VO",       "run A_VO traffic?",                             A_VO);
-  cmd.AddValue ("VO",         "run VO traffic?",                               VO);
-  cmd.AddValue ("VI",         "run VI traffic?",                               VI);
-  cmd.AddValue ("A_VI",       "run A_VI traffic?",                             A_VI);
-  cmd.AddValue ("BE",         "run BE traffic?",                               BE);
-  cmd.AddValue ("BK",         "run BK traffic?",                               BK);
-  cmd.AddValue ("Mbps",       "traffic generated per queue [Mbps]",            Mbps);
-  cmd.AddValue ("seed",       "Seed",                                          seed);
-  cmd.Parse (argc, argv);
+/* ===== single simulation run ===== */
+
+//with variants, the results of every variant are returned in variantResults (see RunVariants)
+SimulationResults
+SimulationHelper::RunSimulation (SimulationParameters params, uint32_t run, bool printFlows, LatencyHistogram *latency,
+                                 std::vector<SimulationResults> *variantResults)
+{
+  uint32_t nSTA = params.nSTA;
+  uint32_t packetSize = params.packetSize;
+  float simTime = params.simTime;
+  Time appsStart = params.appsStart;
+  float calcStart = params.calcStart;
+  bool oneDest = params.oneDest;
+  bool rtsCts = params.rtsCts;
+  bool A_VO = params.A_VO;
+  bool VO = params.VO;
+  bool VI = params.VI;
+  bool A_VI = params.A_VI;
+  bool BE = params.BE;
+  bool BK = params.BK;
+  double Mbps = params.Mbps;
+  uint32_t seed = params.seed;
 
   Time simulationTime = Seconds (simTime);
+  Ipv4AddressGenerator::Reset (); //addresses of a previous run in this process (NodeList itself is emptied by Simulator::Destroy)
   ns3::RngSeedManager::SetSeed (seed);
+  ns3::RngSeedManager::SetRun (run);
  
-  Packet::EnablePrinting ();
+  StringValue simulatorImpl; //bound again after Simulator::Destroy - later scenarios of a file run without the profiler
+  GlobalValue::GetValueByName ("SimulatorImplementationType", simulatorImpl);
+  if (params.profile > 0) //before the first event - the simulator is created on first use
+    {
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::ProfilingSimulatorImpl"));
+      Config::SetDefault ("ns3::ProfilingSimulatorImpl::TopN", UintegerValue (params.profile));
+    }
 
   NodeContainer sta;
-  sta.Create (nSTA+1);
+  sta.Create ((nSTA+1) * params.coChannelBss); //nSTA stations and their destination per BSS
 
 
 
@@ -200,6 +3603,8 @@ int main (int argc, char *argv[])
   MobilityHelper mobility;
   mobility.SetPositionAllocator (positionAlloc);
   mobility.SetMobilityModel ("ns3::ConstantVelocityMobilityModel");
+  if (params.staticNodes) //no velocity is set below - positions can be frozen
+    mobility.SetMobilityModel ("ns3::FrozenPositionMobilityModel");
 
   //constant speed movement configuration
   /*Ptr<ConstantVelocityMobilityModel> mob = sta[std][grp].Get (n)->GetObject<ConstantVelocityMobilityModel> ();
@@ -249,7 +3654,12 @@ int main (int argc, char *argv[])
 /* ===== MAC and PHY configuration ===== */
 
   YansWifiPhyHelper phy;
-  phy.SetChannel (channel.Create ());
+  if (params.gridChannel) //receiver culling by a spatial grid
+    phy = GridYansWifiPhyHelper ();
+  Ptr<YansWifiChannel> wifiChannel = channel.Create ();
+  if (params.lossCache) //static topology - path loss computed once per node pair
+    SimulationHelper::InstallLossCache (wifiChannel);
+  phy.SetChannel (wifiChannel);
 
   WifiHelper wifi;
   WifiMacHelper mac;
@@ -268,6 +3678,8 @@ int main (int argc, char *argv[])
   phy.Set ("Antennas",                     UintegerValue (1) ); //[1-4] for 802.11n/ac - see http://mcsindex.com/
   phy.Set ("MaxSupportedTxSpatialStreams", UintegerValue (1) ); //[1-4] for 802.11n/ac - see http://mcsindex.com/
   phy.Set ("MaxSupportedRxSpatialStreams", UintegerValue (1) ); //[1-4] for 802.11n/ac - see http://mcsindex.com/
+  if (params.channelNumber != 0) //channel of a multi-BSS partition
+    phy.Set ("ChannelNumber",              UintegerValue (params.channelNumber) );
   
 
   //WiFi Remote Station Manager parameters 
@@ -345,6 +3757,11 @@ int main (int argc, char *argv[])
 //  wifi.SetQueueControllerForTid (4, "ns3::CbsaQueueController",
 //                                "IdleSlope", DataRateValue (DataRate (5600000) ) ); //for ~5 Mb/s (5 * 1,12 = 5,6)
 
+  //CBSA settings given in a scenario file
+  for (std::map<uint8_t, DataRate>::const_iterator it = params.cbsaIdleSlope.begin (); it != params.cbsaIdleSlope.end (); it++)
+    wifi.SetQueueControllerForTid (it->first, "ns3::CbsaQueueController",
+                                   "IdleSlope", DataRateValue (it->second) );
+
 
   NetDeviceContainer staDevices = wifi.Install (phy, mac, sta);
 
@@ -353,7 +3770,7 @@ int main (int argc, char *argv[])
 
 //Configs with paths:
   /* !!! IMPORTANT - HERE WE SHOULD SET CHANNEL WIDTH */
-  Config::Set ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/ChannelWidth", UintegerValue (20) ); //for 802.11n/ac - see http://mcsindex.com/
+  uint16_t channelWidth = 20; //for 802.11n/ac - see http://mcsindex.com/ (applied together with queue sizes below)
 
 
 
@@ -395,13 +3812,12 @@ int main (int argc, char *argv[])
   //Config::Set ("/NodeList/*/DeviceList/*/Mac/BE_Txop/Queue/MaxDelay",       TimeValue (MilliSeconds (500)) ); //setting BE frame lifetime
   //Config::Set ("/NodeList/*/DeviceList/*/Mac/BK_Txop/Queue/MaxDelay",       TimeValue (MilliSeconds (500)) ); //setting BK frame lifetime
 
-//Queue Size (in packets):
-  Config::Set ("/NodeList/*/DeviceList/*/Mac/VO_Txop/HiTidQueue/MaxSize",  QueueSizeValue (QueueSize ("10000p")) ); //setting A_VO queue size
-  Config::Set ("/NodeList/*/DeviceList/*/Mac/VO_Txop/LowTidQueue/MaxSize", QueueSizeValue (QueueSize ("10000p")) ); //setting VO queue size
-  Config::Set ("/NodeList/*/DeviceList/*/Mac/VI_Txop/HiTidQueue/MaxSize",  QueueSizeValue (QueueSize ("10000p")) ); //setting VI queue size
-  Config::Set ("/NodeList/*/DeviceList/*/Mac/VI_Txop/LowTidQueue/MaxSize", QueueSizeValue (QueueSize ("10000p")) ); //setting A_VI queue size
-  Config::Set ("/NodeList/*/DeviceList/*/Mac/BE_Txop/Queue/MaxSize",       QueueSizeValue (QueueSize ("10000p")) ); //setting BE queue size
-  Config::Set ("/NodeList/*/DeviceList/*/Mac/BK_Txop/Queue/MaxSize",       QueueSizeValue (QueueSize ("10000p")) ); //setting BK queue size
+//Queue Size (in packets) for all six queues, channel width and EDCA/queue attributes given in a scenario file
+//(e.g. VO_Txop/HiTidQueue/MaxSize) - set directly on every device, or through the Config paths with configPaths=1
+  if (params.configPaths)
+    SimulationHelper::ConfigureWithPaths (channelWidth, QueueSize ("10000p"), params.configOverrides);
+  else
+    SimulationHelper::ConfigureDevices (staDevices, channelWidth, QueueSize ("10000p"), params.configOverrides);
 
   //int64_t streamIndex = 0;
   //wifi.AssignStreams (staDevices, streamIndex);
@@ -415,7 +3831,10 @@ int main (int argc, char *argv[])
 
   Ipv4AddressHelper address;
 
-  address.SetBase ("192.168.1.0", "255.255.255.0");
+  if (sta.GetN () < 255)
+    address.SetBase ("192.168.1.0", "255.255.255.0");
+  else //co-channel BSSs of a multi-BSS partition
+    address.SetBase ("10.0.0.0", "255.0.0.0");
   Ipv4InterfaceContainer staIf;
   staIf = address.Assign (staDevices);
 
@@ -437,49 +3856,72 @@ int main (int argc, char *argv[])
   Ipv4Address destination = staIf.GetAddress(destinationSTANumber);
   Ptr<Node> dest = sta.Get(destinationSTANumber);
 
-  if (oneDest)
+  TidStatistics tidStats (Seconds (calcStart));
+  tidStats.ConnectLosses (staDevices);
+  bool sampling = (params.samplePeriod > 0) || (params.ciTarget > 0);
+  TidSampler sampler (&tidStats, Seconds ((params.samplePeriod > 0) ? params.samplePeriod : 0.1));
+  if (params.ciTarget > 0) //simTime is only the upper limit
+    sampler.SetStopRule (params.ciTarget, Seconds (calcStart),
+                         (A_VO << 7) | (VO << 6) | (VI << 5) | (A_VI << 4) | (BK << 1) | (BE << 0));
+  if (sampling)
+    sampler.Start (appsStart);
+
+  for(uint32_t n = 0; n < sta.GetN (); n++) 
     {
-      if (A_VO) 
-        {
-          PacketSinkHelper sink_A_VO ("ns3::UdpSocketFactory", InetSocketAddress (destination, 1007));
-          sink_A_VO.Install (dest);
-        }
-      if (VO) 
-        {
-          PacketSinkHelper sink_VO ("ns3::UdpSocketFactory", InetSocketAddress (destination, 1006));
-          sink_VO.Install (dest);
-        }
-      if (VI) 
-        {
-          PacketSinkHelper sink_VI ("ns3::UdpSocketFactory", InetSocketAddress (destination, 1005));
-          sink_VI.Install (dest);
-        }
-      if (A_VI) 
+      uint32_t bss = n / (nSTA+1); //co-channel BSSs of a multi-BSS partition - each with its own destination
+      uint32_t i = n % (nSTA+1);
+      if (i == nSTA)
+        continue;
+      Ptr<Node> node = sta.Get(n);
+
+      if (oneDest && (i == 0))
         {
-          PacketSinkHelper sink_A_VI ("ns3::UdpSocketFactory", InetSocketAddress (destination, 1004));
-          sink_A_VI.Install (dest);
+          destinationSTANumber = bss * (nSTA+1) + nSTA;
+          destination = staIf.GetAddress(destinationSTANumber);
+          dest = sta.Get(destinationSTANumber);
+
+          if (A_VO) SimulationHelper::InstallSink (dest, destination, 1007, tidStats);
+          if (VO)   SimulationHelper::InstallSink (dest, destination, 1006, tidStats);
+          if (VI)   SimulationHelper::InstallSink (dest, destination, 1005, tidStats);
+          if (A_VI) SimulationHelper::InstallSink (dest, destination, 1004, tidStats);
+          if (BE)   SimulationHelper::InstallSink (dest, destination, 1000, tidStats);
+          if (BK)   SimulationHelper::InstallSink (dest, destination, 1001, tidStats);
         }
-      if (BE) 
+
+      if (!oneDest) //overwrite for different traffic destinations
         {
-          PacketSinkHelper sink_BE ("ns3::UdpSocketFactory", InetSocketAddress (destination, 1000));
-          sink_BE.Install (dest);
+          destinationSTANumber = bss * (nSTA+1) + ((i+1 == nSTA) ? (0) : (i+1)); 
+          destination = staIf.GetAddress(destinationSTANumber);
+          dest = sta.Get(destinationSTANumber);
+
+          //every destination receives from exactly one source
+          if (A_VO) SimulationHelper::InstallSink (dest, destination, 1007, tidStats);
+          if (VO)   SimulationHelper::InstallSink (dest, destination, 1006, tidStats);
+          if (VI)   SimulationHelper::InstallSink (dest, destination, 1005, tidStats);
+          if (A_VI) SimulationHelper::InstallSink (dest, destination, 1004, tidStats);
+          if (BE)   SimulationHelper::InstallSink (dest, destination, 1000, tidStats);
+          if (BK)   SimulationHelper::InstallSink (dest, destination, 1001, tidStats);
         }
-      if (BK) 
+
+      tidStats.ConnectSource (node);
+
+      const bool enabled[6] = { A_VO, VO, VI, A_VI, BE, BK };
+
+      if (params.macSource) //saturated sources at the MAC level - frames of the same size as UDP/IPv4 packets (+28 B)
         {
-          PacketSinkHelper sink_BK ("ns3::UdpSocketFactory", InetSocketAddress (destination, 1001));
-          sink_BK.Install (dest);
+          for (uint8_t t = 0; t < 6; t++)
+            if (enabled[t])
+              SimulationHelper::InstallMacSource (node, dest, QUEUE_TIDS[t], packetSize + 28, params.macSourceDepth, appsStart, simulationTime, tidStats);
+          continue;
         }
-    }
-
-  for(uint32_t i = 0; i < nSTA; i++) 
-    {
-      Ptr<Node> node = sta.Get(i);
 
-      if (!oneDest) //overwrite for different traffic destinations
+      if (params.backpressure) //CBR sources paused while the queue of their TID is full
         {
-          destinationSTANumber = (i+1 == nSTA) ? (0) : (i+1); 
-          destination = staIf.GetAddress(destinationSTANumber);
-          dest = sta.Get(destinationSTANumber);
+          for (uint8_t t = 0; t < 6; t++)
+            if (enabled[t])
+              SimulationHelper::InstallBackpressureSource (node, InetSocketAddress (destination, 1000 + QUEUE_TIDS[t]), dataRate, packetSize, QUEUE_TIDS[t],
+                                                           appsStart, simulationTime, params.backpressureThreshold, tidStats);
+          continue;
         }
 
       if (A_VO) 
@@ -517,51 +3959,159 @@ int main (int argc, char *argv[])
 
 /* ===== tracing configuration and running simulation === */
 
-  SimulationHelper::PopulateArpCache ();
+  SimulationHelper::PopulateArpCache (params.fast);
   //Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
   Simulator::Stop (simulationTime);
 
-  //phy.EnablePcap ("out", nSTA-1, 0); // sniffing to pcap file
+  //phy.EnablePcap ("out", nSTA-1, 0); // sniffing to pcap file - see pcapFile for a sampled capture
   //AsciiTraceHelper ascii;
   //phy.EnableAsciiAll (ascii.CreateFileStream ("out.tr"));
   //phy.EnableAscii (ascii.CreateFileStream ("out.tr"), sta.Get (1)->GetDevice (1));
   //mac.EnableAsciiAll (ascii.CreateFileStream ("out.tr"));
 
+  //binary packet event trace - replaces the ASCII traces above
+  EventTracer eventTracer;
+  if (!params.eventTrace.empty ())
+    {
+      eventTracer.Open (params.eventTrace, params.eventTraceRecords);
+      eventTracer.Connect (staDevices);
+    }
+  SampledPcapWriter pcap;
+  if (!params.pcapFile.empty ())
+    {
+      pcap.Open (params.pcapFile, params.pcapSample, params.pcapSnapLen);
+      pcap.Connect (staDevices);
+    }
+  QueueOccupancy occupancy (Seconds (calcStart));
+  bool queueStats = params.queueStats || !params.queueSampleFile.empty ();
+  if (queueStats)
+    {
+      occupancy.Connect (staDevices);
+      if (!params.queueSampleFile.empty ())
+        occupancy.StartSampling (params.queueSampleFile, Seconds ((params.samplePeriod > 0) ? params.samplePeriod : 0.1));
+    }
+
+  //FlowMonitor is only needed for per-flow results - per-TID results come from tidStats
   FlowMonitorHelper flowmon_helper;
-  Ptr<FlowMonitor> monitor = flowmon_helper.InstallAll ();
-  monitor->SetAttribute ("StartTime", TimeValue (Seconds (calcStart) ) ); //Time from which flowmonitor statistics are gathered.
-  monitor->SetAttribute ("DelayBinWidth", DoubleValue (0.001));
-  monitor->SetAttribute ("JitterBinWidth", DoubleValue (0.001));
-  monitor->SetAttribute ("PacketSizeBinWidth", DoubleValue (20));
+  Ptr<FlowMonitor> monitor;
+  if (params.flowMonitor)
+    {
+      monitor = flowmon_helper.InstallAll ();
+      monitor->SetAttribute ("StartTime", TimeValue (Seconds (calcStart) ) ); //Time from which flowmonitor statistics are gathered.
+      monitor->SetAttribute ("DelayBinWidth", DoubleValue (0.001));
+      monitor->SetAttribute ("JitterBinWidth", DoubleValue (0.001));
+      monitor->SetAttribute ("PacketSizeBinWidth", DoubleValue (20));
+    }
 
+  std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now ();
+  int resultFd = -1; //forked variant - pipe to the parent
+  if (!params.variants.empty ()) //warm-up up to the branch time, then each variant in a forked copy
+    {
+      NS_ASSERT (variantResults != 0);
+      Simulator::Stop (Seconds (params.branchTime));
+      Simulator::Run ();
+      int variant = SimulationHelper::ForkVariants (params, *variantResults, resultFd);
+      if (variant < 0) //parent - all variants done
+        {
+          Simulator::Destroy ();
+          GlobalValue::Bind ("SimulatorImplementationType", simulatorImpl);
+          return (*variantResults)[0];
+        }
+      params = SimulationHelper::WithFileSuffix (params, "-" + params.variants[variant].name);
+      printFlows = false;
+      Ptr<ProfilingSimulatorImpl> profiler = DynamicCast<ProfilingSimulatorImpl> (Simulator::GetImplementation ());
+      if (profiler != 0) //the warm-up is reported once, by the parent
+        profiler->Reset ();
+      SimulationHelper::ApplyVariant (sta, params.variants[variant]);
+    }
   Simulator::Run ();
+  Time calcStop = Simulator::Now (); //simulationTime, unless stopped by the sampler
+  if (params.perfReport)
+    {
+      SimulationHelper::PrintPerfReport (std::chrono::duration<double> (std::chrono::steady_clock::now () - runStart).count (), Simulator::Now ());
+      Ptr<ReceiverGrid> grid = wifiChannel->GetObject<ReceiverGrid> ();
+      if (grid != 0)
+        std::cout << "  Receptions:\t" << grid->GetDelivered () << " scheduled, " << grid->GetCulled () << " culled" << std::endl;
+      PointerValue loss;
+      wifiChannel->GetAttribute ("PropagationLossModel", loss);
+      Ptr<CachedPropagationLossModel> cached = DynamicCast<CachedPropagationLossModel> (loss.Get<PropagationLossModel> ());
+      if (cached != 0)
+        std::cout << "  Loss cache:\t" << cached->GetHits () << " hits, " << cached->GetMisses () << " misses" << std::endl;
+      if (!params.eventTrace.empty ())
+        std::cout << "  Trace events:\t" << eventTracer.GetWritten () << std::endl;
+      if (!params.pcapFile.empty ())
+        std::cout << "  Pcap frames:\t" << pcap.GetCaptured () << " of " << pcap.GetSeen () << " captured" << std::endl;
+      if (params.staticNodes)
+        {
+          uint64_t queries = 0; //of this run only
+          for (uint32_t n = 0; n < sta.GetN (); n++)
+            {
+              Ptr<FrozenPositionMobilityModel> frozen = sta.Get (n)->GetObject<FrozenPositionMobilityModel> ();
+              if (frozen != 0)
+                queries += frozen->GetQueries ();
+            }
+          std::cout << "  Position queries:\t" << queries << " ("
+                    << queries / Simulator::Now ().GetSeconds () << " per simulated s)" << std::endl;
+        }
+    }
+  eventTracer.Close ();
+  pcap.Close ();
   Simulator::Destroy ();
+  GlobalValue::Bind ("SimulatorImplementationType", simulatorImpl);
 
 
 
 /* ===== printing results ===== */
 
-  monitor->CheckForLostPackets();
-  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon_helper.GetClassifier ());
-  //monitor->SerializeToXmlFile ("out.xml", true, true);
+  SimulationResults results;
+  std::memset (&results, 0, sizeof (results));
+  tidStats.Fill (results, calcStop);
+  if (latency != 0) //merged by the parent of a worker
+    for (uint8_t tid = 0; tid < 8; tid++)
+      latency[tid] = tidStats.GetLatency (tid);
+  results.stopTime = calcStop.GetSeconds ();
+  results.nodes = sta.GetN ();
+  results.ciReached = sampler.CiReached ();
+  if (queueStats)
+    {
+      occupancy.Fill (results, calcStop);
+      if (printFlows)
+        occupancy.PrintNodes (calcStop);
+    }
+  if (sampling)
+    {
+      sampler.Fill (results);
+      if (!params.sampleFile.empty ())
+        sampler.Write (params.sampleFile);
+    }
+
+  Ptr<Ipv4FlowClassifier> classifier;
+  if (params.flowMonitor)
+    {
+      monitor->CheckForLostPackets();
+      classifier = DynamicCast<Ipv4FlowClassifier> (flowmon_helper.GetClassifier ());
+      //monitor->SerializeToXmlFile ("out.xml", true, true);
+    }
 
-  std::string proto;
-  uint64_t txBytes = 0, rxBytes = 0, txPackets = 0, rxPackets = 0, lostPackets = 0;
-  double throughput;
-  Time delaySum = Seconds (0), jitterSum = Seconds (0);
+  if (!params.resultsFile.empty ())
+    SimulationHelper::WriteBinaryResults (params.resultsFile, params, run, results, tidStats, monitor, classifier);
+
+  if (resultFd >= 0) //forked variant - nothing more to do than hand the results to the parent
+    {
+      if (!SimulationHelper::WriteAll (resultFd, &results, sizeof (results)))
+        _exit (1);
+      close (resultFd);
+      std::cout.flush ();
+      _exit (0);
+    }
 
-  std::vector<uint64_t> txBytesPerTid     = std::vector<uint64_t> (8, 0);
-  std::vector<uint64_t> rxBytesPerTid     = std::vector<uint64_t> (8, 0);
-  std::vector<uint64_t> txPacketsPerTid   = std::vector<uint64_t> (8, 0);
-  std::vector<uint64_t> rxPacketsPerTid   = std::vector<uint64_t> (8, 0);
-  std::vector<uint64_t> lostPacketsPerTid = std::vector<uint64_t> (8, 0);
-  std::vector<double>   throughputPerTid  = std::vector<double>   (8, 0.0);
-  std::vector<Time>     delaySumPerTid    = std::vector<Time>     (8, Seconds (0) );
-  std::vector<Time>     jitterSumPerTid   = std::vector<Time>     (8, Seconds (0) );
+  if (!params.flowMonitor)
+    return results;
 
+  std::string proto;
   std::map< FlowId, FlowMonitor::FlowStats > stats = monitor->GetFlowStats();
-  for (std::map< FlowId, FlowMonitor::FlowStats >::iterator flow = stats.begin (); flow != stats.end (); flow++)
+  for (std::map< FlowId, FlowMonitor::FlowStats >::iterator flow = stats.begin (); flow != stats.end () && printFlows; flow++)
     {
       Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (flow->first);
       switch (t.protocol)
@@ -588,8 +4138,15 @@ int main (int argc, char *argv[])
       if (flow->second.rxPackets > 0)
         {
           //std::cout << "  Throughput:\t"   << flow->second.rxBytes * 8.0 / (flow->second.timeLastRxPacket.GetSeconds ()-flow->second.timeFirstTxPacket.GetSeconds ()) / 1000000  << " Mb/s" << std::endl;
-          std::cout << "  Throughput:\t"   << flow->second.rxBytes * 8.0 / (simulationTime - Seconds (calcStart)).GetMicroSeconds ()  << " Mb/s" << std::endl;
+          std::cout << "  Throughput:\t"   << flow->second.rxBytes * 8.0 / (calcStop - Seconds (calcStart)).GetMicroSeconds ()  << " Mb/s" << std::endl;
           std::cout << "  Mean delay:\t"   << (double)(flow->second.delaySum / (flow->second.rxPackets)).GetMicroSeconds () / 1000 << " ms" << std::endl;    
+          const LatencyHistogram *latency = tidStats.GetFlowLatency (t.sourceAddress, t.sourcePort);
+          if (latency != 0)
+            {
+              std::cout << "  Delay p50:\t"    << latency->GetPercentile (0.5)   << " ms" << std::endl;
+              std::cout << "  Delay p99:\t"    << latency->GetPercentile (0.99)  << " ms" << std::endl;
+              std::cout << "  Delay p99.9:\t"  << latency->GetPercentile (0.999) << " ms" << std::endl;
+            }
           if (flow->second.rxPackets > 1)
             std::cout << "  Mean jitter:\t"  << (double)(flow->second.jitterSum / (flow->second.rxPackets - 1)).GetMicroSeconds () / 1000 << " ms" << std::endl;   
           else
@@ -601,54 +4158,78 @@ int main (int argc, char *argv[])
           std::cout << "  Mean delay:\t---"    << std::endl;    
           std::cout << "  Mean jitter:\t---"   << std::endl;
         }
-
-      uint16_t tid = t.destinationPort-1000;
-      txBytesPerTid[tid]     += flow->second.txBytes;
-      rxBytesPerTid[tid]     += flow->second.rxBytes;
-      txPacketsPerTid[tid]   += flow->second.txPackets;
-      rxPacketsPerTid[tid]   += flow->second.rxPackets;
-      lostPacketsPerTid[tid] += flow->second.lostPackets;
-      //throughputPerTid[tid]  += (flow->second.rxPackets > 0 ? flow->second.rxBytes * 8.0 / (flow->second.timeLastRxPacket.GetSeconds ()-flow->second.timeFirstTxPacket.GetSeconds ()) / 1000000 : 0);
-      throughputPerTid[tid]  += (flow->second.rxPackets > 0 ? flow->second.rxBytes * 8.0 / (simulationTime - Seconds (calcStart)).GetMicroSeconds () : 0);
-      delaySumPerTid[tid]    += flow->second.delaySum;
-      jitterSumPerTid[tid]   += flow->second.jitterSum;
-
-      txBytes     += flow->second.txBytes;
-      rxBytes     += flow->second.rxBytes;
-      txPackets   += flow->second.txPackets;
-      rxPackets   += flow->second.rxPackets;
-      lostPackets += flow->second.lostPackets;
-      //throughput  += (flow->second.rxPackets > 0 ? flow->second.rxBytes * 8.0 / (flow->second.timeLastRxPacket.GetSeconds ()-flow->second.timeFirstTxPacket.GetSeconds ()) / 1000000 : 0);
-      throughput  += (flow->second.rxPackets > 0 ? flow->second.rxBytes * 8.0 / (simulationTime - Seconds (calcStart)).GetMicroSeconds () : 0);
-      delaySum    += flow->second.delaySum;
-      jitterSum   += flow->second.jitterSum;
     }
 
+  return results;
+}
+
+//print per-TID and total results of a single run
+void
+SimulationHelper::PrintResults (const SimulationResults &results)
+{
+  uint64_t txBytes = 0, rxBytes = 0, txPackets = 0, rxPackets = 0, lostPackets = 0, inFlightPackets = 0;
+  double throughput = 0;
+  Time delaySum = Seconds (0), jitterSum = Seconds (0);
+
   for (uint16_t tid = 0; tid < 8; tid++)
-    if ((tid != 2) && (tid != 3))
-      {
-        std::cout << "=======================TID: " << tid << " =====================================" << std::endl;
-
-        std::cout << "  Tx bytes:\t"     << txBytesPerTid[tid]     << std::endl;
-        std::cout << "  Rx bytes:\t"     << rxBytesPerTid[tid]     << std::endl;
-        std::cout << "  Tx packets:\t"   << txPacketsPerTid[tid]   << std::endl;
-        std::cout << "  Rx packets:\t"   << rxPacketsPerTid[tid]   << std::endl;
-        std::cout << "  Lost packets:\t" << lostPacketsPerTid[tid] << std::endl;
-        std::cout << "  Throughput:\t"   << throughputPerTid[tid]  << " Mb/s" << std::endl;
-        if (rxPacketsPerTid[tid] > 0)
-          {
-            std::cout << "  Mean delay:\t"   << (double)(delaySumPerTid[tid] / (rxPacketsPerTid[tid])).GetMicroSeconds () / 1000 << " ms" << std::endl;    
-            if (rxPacketsPerTid[tid] > 1)  
-              std::cout << "  Mean jitter:\t"  << (double)(jitterSumPerTid[tid] / (rxPacketsPerTid[tid] - 1)).GetMicroSeconds () / 1000  << " ms" << std::endl;   
-            else
-              std::cout << "  Mean jitter:\t---"   << std::endl;
-          }
-        else
-          {
-            std::cout << "  Mean delay:\t---"    << std::endl;    
+    {
+      const TidResults &r = results.tid[tid];
+
+      txBytes     += r.txBytes;
+      rxBytes     += r.rxBytes;
+      txPackets   += r.txPackets;
+      rxPackets   += r.rxPackets;
+      lostPackets += r.lostPackets;
+      inFlightPackets += r.inFlightPackets;
+      throughput  += r.throughput;
+      delaySum    += NanoSeconds (r.delaySum);
+      jitterSum   += NanoSeconds (r.jitterSum);
+
+      if ((tid == 2) || (tid == 3))
+        continue;
+
+      std::cout << "=======================TID: " << tid << " =====================================" << std::endl;
+
+      std::cout << "  Tx bytes:\t"     << r.txBytes     << std::endl;
+      std::cout << "  Rx bytes:\t"     << r.rxBytes     << std::endl;
+      std::cout << "  Tx packets:\t"   << r.txPackets   << std::endl;
+      std::cout << "  Rx packets:\t"   << r.rxPackets   << std::endl;
+      std::cout << "  Lost packets:\t" << r.lostPackets << std::endl;
+      std::cout << "  In flight at end:\t" << r.inFlightPackets << std::endl;
+      std::cout << "  Throughput:\t"   << r.throughput  << " Mb/s" << std::endl;
+      if (r.offeredPackets > 0) //backpressure sources - generated load (Tx) is lower than offered load
+        {
+          std::cout << "  Offered packets:\t" << r.offeredPackets << std::endl;
+          std::cout << "  Offered load:\t"    << r.offeredLoad    << " Mb/s" << std::endl;
+        }
+      if (r.rxPackets > 0)
+        {
+          std::cout << "  Mean delay:\t"   << (double)(NanoSeconds (r.delaySum) / (r.rxPackets)).GetMicroSeconds () / 1000 << " ms" << std::endl;    
+          std::cout << "  Delay p50:\t"    << r.delayP50  << " ms" << std::endl;
+          std::cout << "  Delay p99:\t"    << r.delayP99  << " ms" << std::endl;
+          std::cout << "  Delay p99.9:\t"  << r.delayP999 << " ms" << std::endl;
+          if (r.rxPackets > 1)  
+            std::cout << "  Mean jitter:\t"  << (double)(NanoSeconds (r.jitterSum) / (r.rxPackets - 1)).GetMicroSeconds () / 1000  << " ms" << std::endl;   
+          else
             std::cout << "  Mean jitter:\t---"   << std::endl;
-          }
-      }
+        }
+      else
+        {
+          std::cout << "  Mean delay:\t---"    << std::endl;    
+          std::cout << "  Mean jitter:\t---"   << std::endl;
+        }
+      if (r.samples > 0) //time series sampled - results after the detected transient
+        {
+          if (r.warmup >= 0)
+            {
+              std::cout << "  Warm-up (MSER-5):\t" << r.warmup << " s" << std::endl;
+              std::cout << "  Steady throughput:\t" << r.steadyThroughput << " Mb/s" << std::endl;
+              std::cout << "  Steady mean delay:\t" << r.steadyDelay << " ms" << std::endl;
+            }
+          else
+            std::cout << "  Warm-up (MSER-5):\tno steady state detected - run longer" << std::endl;
+        }
+    }
 
   std::cout << "=======================Total: =====================================" << std::endl;
 
@@ -657,10 +4238,14 @@ int main (int argc, char *argv[])
   std::cout << "  Tx packets:\t"   << txPackets   << std::endl;
   std::cout << "  Rx packets:\t"   << rxPackets   << std::endl;
   std::cout << "  Lost packets:\t" << lostPackets << std::endl;
+  std::cout << "  In flight at end:\t" << inFlightPackets << std::endl;
   std::cout << "  Throughput:\t"   << throughput  << " Mb/s" << std::endl;
   if (rxPackets > 0)
     {
       std::cout << "  Mean delay:\t"   << (double)(delaySum / (rxPackets)).GetMicroSeconds () / 1000 << " ms" << std::endl;    
+      std::cout << "  Delay p50:\t"    << results.totalDelayP50  << " ms" << std::endl;
+      std::cout << "  Delay p99:\t"    << results.totalDelayP99  << " ms" << std::endl;
+      std::cout << "  Delay p99.9:\t"  << results.totalDelayP999 << " ms" << std::endl;
       if (rxPackets > 1)  
         std::cout << "  Mean jitter:\t"  << (double)(jitterSum / (rxPackets - 1)).GetMicroSeconds () / 1000  << " ms" << std::endl;   
       else
@@ -671,6 +4256,216 @@ int main (int argc, char *argv[])
       std::cout << "  Mean delay:\t---"    << std::endl;    
       std::cout << "  Mean jitter:\t---"   << std::endl;
     }
+  if (results.ciReached)
+    std::cout << "  Stopped at:\t"  << results.stopTime << " s (ciTarget reached)" << std::endl;
+
+  if (!results.queueStats)
+    return;
+  std::cout << "=======================Queues: (peak over nodes, mean / max time average after calcStart) ====" << std::endl;
+  for (uint8_t q = 0; q < QueueOccupancy::QUEUES; q++)
+    {
+      const QueueResults &r = results.queue[q];
+      std::cout << "  " << QueueOccupancy::GetName (q) << ":\t" << r.peak << " packets (node " << r.peakNode << "), "
+                << r.meanAverage << " / " << r.maxAverage << " packets" << std::endl;
+    }
+  if (results.partitions > 1) //peaks of the partitions need not coincide
+    std::cout << "  Sum of partition peaks:\t";
+  else
+    std::cout << "  Queued peak:\t";
+  std::cout << results.queuedPeakPackets << " packets, " << results.queuedPeakBytes << " B (all queues)" << std::endl;
+}
+
+
+
+/* ===== main function ===== */
+
+int main (int argc, char *argv[])
+{
+  SimulationParameters params;
+  params.nSTA = 3;
+  params.packetSize = 1470;
+  params.simTime = 10;
+  params.appsStart = Seconds(0);
+  params.radius = 1.0;
+  params.calcStart = 0;
+  params.oneDest = true;
+  params.rtsCts = false;
+  params.A_VO = true;
+  params.VO = true;
+  params.VI = true;
+  params.A_VI = true;
+  params.BE = true;
+  params.BK = true;
+  params.Mbps = 54;
+  params.seed = 1;
+  params.flowMonitor = false;
+  params.resultsFile = "";
+  params.configPaths = false;
+  params.fast = false;
+  params.perfReport = false;
+  params.macSource = false;
+  params.macSourceDepth = 2;
+  params.backpressure = false;
+  params.backpressureThreshold = 0;
+  params.samplePeriod = 0;
+  params.ciTarget = 0;
+  params.gridChannel = false;
+  params.lossCache = false;
+  params.staticNodes = false;
+  params.profile = 0;
+  params.eventTrace = "";
+  params.eventTraceRecords = 1 << 22;
+  params.pcapFile = "";
+  params.pcapSample = "1";
+  params.pcapSnapLen = 0;
+  params.sampleFile = "";
+  params.nBss = 0;
+  params.staPerBss = 0;
+  params.bssChannels = 0;
+  params.coChannelBss = 1;
+  params.channelNumber = 0;
+  params.queueStats = false;
+  params.queueSampleFile = "";
+  params.branchTime = 0;
+  params.variantJobs = 1;
+  uint32_t replications = 1;
+  uint32_t jobs = 0;
+  std::string scenarioFile = "";
+  std::string variantFile = "";
+  bool setupBenchmark = false;
+  bool analytic = false;
+  bool analyticCheck = false;
+
+
+/* ===== Command Line parameters ===== */
+
+  CommandLine cmd;
+  cmd.AddValue ("nSTA",         "Number of stations",                            params.nSTA);
+  cmd.AddValue ("packetSize",   "Packet size [B]",                               params.packetSize);
+  cmd.AddValue ("simTime",      "simulation time [s]",                           params.simTime);
+  cmd.AddValue ("calcStart",    "start of results analysis [s]",                 params.calcStart);
+  cmd.AddValue ("radius",       "Radius of area [m] to randomly place stations", params.radius);
+  cmd.AddValue ("oneDest",      "use one traffic destination?",                  params.oneDest);
+  cmd.AddValue ("RTSCTS",       "use RTS/CTS?",                                  params.rtsCts);
+  cmd.AddValue ("A_VO",         "run A_VO traffic?",                             params.A_VO);
+  cmd.AddValue ("VO",           "run VO traffic?",                               params.VO);
+  cmd.AddValue ("VI",           "run VI traffic?",                               params.VI);
+  cmd.AddValue ("A_VI",         "run A_VI traffic?",                             params.A_VI);
+  cmd.AddValue ("BE",           "run BE traffic?",                               params.BE);
+  cmd.AddValue ("BK",           "run BK traffic?",                               params.BK);
+  cmd.AddValue ("Mbps",         "traffic generated per queue [Mbps]",            params.Mbps);
+  cmd.AddValue ("seed",         "Seed",                                          params.seed);
+  cmd.AddValue ("flowMonitor",  "install FlowMonitor and print per-flow results?", params.flowMonitor);
+  cmd.AddValue ("resultsFile",  "binary results file (per-flow part needs flowMonitor=1)", params.resultsFile);
+  cmd.AddValue ("configPaths",  "configure devices through Config::Set paths?",  params.configPaths);
+  cmd.AddValue ("fast",         "fast mode: no packet metadata, ARP cache without dummy packets (one value for all scenarios of a file)", params.fast);
+  cmd.AddValue ("perfReport",   "print wall time, events/s and peak RSS of the run", params.perfReport);
+  cmd.AddValue ("macSource",    "saturated sources at the MAC level instead of OnOff/UDP?", params.macSource);
+  cmd.AddValue ("macSourceDepth", "frames kept in each queue by MAC-level sources", params.macSourceDepth);
+  cmd.AddValue ("backpressure", "pause CBR sources while the queue of their TID is full?", params.backpressure);
+  cmd.AddValue ("backpressureThreshold", "queue occupancy [packets, bytes for a limit in bytes] pausing backpressure sources (0 - queue limit)", params.backpressureThreshold);
+  cmd.AddValue ("samplePeriod", "per-TID time series sampling period [s] with MSER-5 warm-up detection (0 - off)", params.samplePeriod);
+  cmd.AddValue ("ciTarget",     "stop when the relative 95% CI half-width of all TIDs is below this (e.g. 0.02; simTime - upper limit, 0 - off)", params.ciTarget);
+  cmd.AddValue ("gridChannel",  "deliver frames only to PHYs within reception range (spatial grid)?", params.gridChannel);
+  cmd.AddValue ("lossCache",    "cache the path loss per node pair (recomputed after course changes)?", params.lossCache);
+  cmd.AddValue ("profile",      "print the N callback targets taking most wall time (events and time per target; 0 - off)", params.profile);
+  cmd.AddValue ("eventTrace",   "binary packet event trace file (memory-mapped ring, see wifi_jows_events.py)", params.eventTrace);
+  cmd.AddValue ("eventTraceRecords", "capacity of the event trace ring [records of 32 B]", params.eventTraceRecords);
+  cmd.AddValue ("pcapFile",     "sampled, truncated radiotap pcap of transmitted frames", params.pcapFile);
+  cmd.AddValue ("pcapSample",   "pcap sampling - keep 1 in N frames: N (all), TID:N, ctl:N (non-QoS frames), comma-separated", params.pcapSample);
+  cmd.AddValue ("pcapSnapLen",  "pcap bytes kept per frame (0 - MAC, LLC, IP and UDP headers)", params.pcapSnapLen);
+  cmd.AddValue ("staticNodes",  "nodes never move - frozen positions instead of ConstantVelocityMobilityModel?", params.staticNodes);
+  cmd.AddValue ("sampleFile",   "CSV file for the per-TID time series (needs samplePeriod)", params.sampleFile);
+  cmd.AddValue ("queueStats",   "report peak and time-averaged occupancy of every AltEDCA queue?", params.queueStats);
+  cmd.AddValue ("queueSampleFile", "CSV time series of the queue occupancy (period: samplePeriod or 0.1 s; implies queueStats)", params.queueSampleFile);
+  cmd.AddValue ("nBss",         "co-located BSSs on separate channels, partitions run in parallel workers (0 - single BSS)", params.nBss);
+  cmd.AddValue ("staPerBss",    "stations per BSS (0 - nSTA)",                   params.staPerBss);
+  cmd.AddValue ("bssChannels",  "20 MHz channels the BSSs are spread over - co-channel BSSs are simulated together (0 - all 24)", params.bssChannels);
+  cmd.AddValue ("replications", "number of independent runs (run numbers 1..N)", replications);
+  cmd.AddValue ("jobs",         "number of parallel worker processes (0 - 1, multi-BSS: all CPUs)", jobs);
+  cmd.AddValue ("scenarioFile", "file with parameter sets to run one after another", scenarioFile);
+  cmd.AddValue ("variantFile",  "variants forked from the state at branchTime, each continued to simTime (parallel: jobs)", variantFile);
+  cmd.AddValue ("branchTime",   "end of the warm-up shared by the variants [s] (calcStart >= branchTime compares the variants only)", params.branchTime);
+  cmd.AddValue ("analytic",     "only evaluate the analytical EDCA saturation model (no simulation)", analytic);
+  cmd.AddValue ("analyticCheck", "simulate and compare per-TID throughput with the analytical EDCA model", analyticCheck);
+  cmd.AddValue ("setupBenchmark", "compare Config paths and typed setup for 10-5000 stations", setupBenchmark);
+  cmd.Parse (argc, argv);
+
+  if (setupBenchmark)
+    {
+      uint32_t sizes[] = { 10, 100, 1000, 5000 };
+      SimulationHelper::BenchmarkSetup (std::vector<uint32_t> (sizes, sizes + 4));
+      return 0;
+    }
+
+  if (!variantFile.empty ())
+    params.variants = SimulationHelper::ParseVariantFile (variantFile);
+
+  std::vector<std::pair<std::string, SimulationParameters> > scenarios;
+  if (scenarioFile.empty ())
+    scenarios.push_back (std::make_pair ("", params));
+  else
+    scenarios = SimulationHelper::ParseScenarioFile (scenarioFile, params);
+
+  //packet metadata is never printed - fast mode saves its bookkeeping on every packet; once enabled it cannot
+  //be switched off, so fast is decided once for the whole process (and inherited by forked workers)
+  for (uint32_t i = 1; i < scenarios.size (); i++)
+    if (scenarios[i].second.fast != scenarios[0].second.fast)
+      NS_FATAL_ERROR ("scenario " << scenarios[i].first << ": fast must be the same in all scenarios of a file (packet metadata is process-wide)");
+  if (!scenarios[0].second.fast)
+    Packet::EnablePrinting ();
+
+  for (uint32_t i = 0; i < scenarios.size (); i++)
+    {
+      if (!scenarioFile.empty ())
+        std::cout << "#######################Scenario: " << scenarios[i].first << " #####################" << std::endl;
+
+      if (analytic) //screening - model only, no simulation
+        {
+          SimulationHelper::PrintAnalytic (SimulationHelper::AnalyticModel (scenarios[i].second), scenarios[i].second, 0);
+          continue;
+        }
+
+      SimulationResults results;
+      if (!scenarios[i].second.variants.empty ())
+        {
+          if (replications > 1)
+            NS_FATAL_ERROR ("variants cannot be combined with replications");
+          std::vector<SimulationResults> variantResults = SimulationHelper::RunVariants (scenarios[i].second, std::max (jobs, 1u));
+          for (uint32_t v = 0; v < variantResults.size (); v++)
+            {
+              std::cout << "#######################Variant: " << scenarios[i].second.variants[v].name << " #####################" << std::endl;
+              SimulationHelper::PrintResults (variantResults[v]);
+            }
+          results = variantResults[0]; //base, for analyticCheck
+        }
+      else if (scenarios[i].second.nBss > 0)
+        {
+          if (replications > 1)
+            NS_FATAL_ERROR ("nBss cannot be combined with replications");
+          long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+          results = SimulationHelper::RunMultiBss (scenarios[i].second, (jobs > 0) ? jobs : std::max (cpus, 1L));
+          SimulationHelper::PrintResults (results);
+        }
+      else if (replications > 1)
+        {
+          std::vector<SimulationResults> replicationResults = SimulationHelper::RunReplications (scenarios[i].second, replications, std::max (jobs, 1u));
+          SimulationHelper::PrintReplicationSummary (replicationResults);
+
+          std::memset (&results, 0, sizeof (results)); //mean throughput for analyticCheck
+          for (uint32_t r = 0; r < replicationResults.size (); r++)
+            for (uint8_t tid = 0; tid < 8; tid++)
+              results.tid[tid].throughput += replicationResults[r].tid[tid].throughput / replicationResults.size ();
+        }
+      else
+        {
+          results = SimulationHelper::RunSimulation (scenarios[i].second, 1, true);
+          SimulationHelper::PrintResults (results);
+        }
+
+      if (analyticCheck)
+        SimulationHelper::PrintAnalytic (SimulationHelper::AnalyticModel (scenarios[i].second), scenarios[i].second, &results);
+    }
 
   return 0;
 }
@@ -0,0 +1,244 @@
+#! /usr/bin/env python3
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+
+# Content-addressed on-disk store of simulation results, used by wifi_jows_sweep.py and usable as a
+# wrapper for any example (wifi_jows_2_new, scratch/wifi-backward-compatibility, ...):
+#
+#   ./wifi_jows_cache.py [--cache DIR] [--binary PATH] PROGRAM --name=value ...
+#
+# The key is a SHA-256 of the canonical command line (options sorted, last value wins as in
+# ns3::CommandLine), the contents of input files named on it (scenarioFile, variantFile), NS_GLOBAL_VALUE and the
+# build IDs of the binary and of the libns3* shared libraries it loads (GNU build-id note, or a hash of the file) -
+# the simulator code of a default waf build is in the libraries, not in the binary. A run whose libraries cannot be
+# located (no ldd, library not found) is not cached. A hit prints the stored output
+# and restores the output files of the run (resultsFile, sampleFile, eventTrace, pcapFile, queueSampleFile) or re-appends the rows the run
+# added to the CSV of wifi-backward-compatibility; a miss runs the program and stores the same.
+
+import argparse
+import glob
+import hashlib
+import json
+import os
+import shlex
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+DEFAULT_CACHE = os.path.expanduser('~/.cache/wifi_jows')
+DEFAULT_COMMAND = './waf --run-no-build "{program} {args}"'
+
+# files read (inputs) or written (outputs, prefix of the file names; appends, file grown by the run)
+PROGRAMS = {
+    'wifi_jows_2_new': {'inputs': ['scenarioFile', 'variantFile'], 'outputs': ['resultsFile', 'sampleFile', 'eventTrace', 'pcapFile', 'queueSampleFile'], 'appends': {}},
+    'wifi-backward-compatibility': {'inputs': [], 'outputs': [], 'appends': {'outputFileName': ('%s.csv', 'default')}},
+}
+
+
+def parse_args(args):
+    options = {}
+    for arg in args:
+        name, _, value = arg.lstrip('-').partition('=')
+        options[name] = value
+    return options
+
+
+def canonical_args(options):
+    return ' '.join('--%s=%s' % (k, options[k]) for k in sorted(options))
+
+
+def file_digest(path):
+    h = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 20), b''):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def build_id(path):
+    """GNU build-id of an ELF binary, or the SHA-256 of the file if it has none"""
+    with open(path, 'rb') as f:
+        data = f.read()
+    marker = data.find(b'GNU\0')
+    while marker >= 12:
+        namesz, descsz, ntype = struct.unpack_from('<III', data, marker - 12)
+        if namesz == 4 and ntype == 3 and 0 < descsz <= 64:  # NT_GNU_BUILD_ID
+            return data[marker + 4:marker + 4 + descsz].hex()
+        marker = data.find(b'GNU\0', marker + 4)
+    return hashlib.sha256(data).hexdigest()
+
+
+def ns3_libraries(binary):
+    """libns3* shared libraries loaded by the binary (empty for a static build), None if they cannot be located"""
+    env = dict(os.environ)
+    directory = os.path.dirname(os.path.abspath(binary))
+    while os.path.dirname(directory) != directory:  # waf runs the programs with build/lib on the library path
+        if os.path.isdir(os.path.join(directory, 'lib')):
+            env['LD_LIBRARY_PATH'] = os.pathsep.join(filter(None, (os.path.join(directory, 'lib'),
+                                                                   env.get('LD_LIBRARY_PATH'))))
+            break
+        directory = os.path.dirname(directory)
+    try:
+        proc = subprocess.run(['ldd', binary], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                              universal_newlines=True, env=env)
+    except OSError:
+        return None
+    libraries = []
+    for line in proc.stdout.splitlines():
+        name, _, location = line.strip().partition(' => ')
+        if not name.startswith('libns3'):
+            continue
+        path = location.split(' (')[0].strip()
+        if not os.path.isfile(path):  # "not found"
+            return None
+        libraries.append(path)
+    return sorted(libraries)
+
+
+def find_binary(program, root='build'):
+    """newest executable built for the program (waf names them ns3.XX-PROGRAM-PROFILE)"""
+    candidates = [p for p in glob.glob(os.path.join(root, '**', '*%s*' % program), recursive=True)
+                  if os.path.isfile(p) and os.access(p, os.X_OK)]
+    if not candidates:
+        raise FileNotFoundError('no binary for %s under %s (use --binary)' % (program, root))
+    return max(candidates, key=os.path.getmtime)
+
+
+class ResultCache:
+    def __init__(self, directory=DEFAULT_CACHE):
+        self.directory = directory
+        self._build_ids = {}
+
+    def _build_id(self, binary):
+        stamp = (binary, os.path.getmtime(binary))
+        if stamp not in self._build_ids:
+            self._build_ids[stamp] = build_id(binary)
+        return self._build_ids[stamp]
+
+    def key(self, program, options, binary):
+        """None if the libraries of the binary cannot be located - the run is then not cached"""
+        libraries = ns3_libraries(binary)
+        if libraries is None:
+            return None
+        spec = PROGRAMS.get(program, {})
+        h = hashlib.sha256()
+        h.update(('program %s\nbuild %s\nargs %s\nenv %s\n' % (
+            program, self._build_id(binary), canonical_args(options), os.environ.get('NS_GLOBAL_VALUE', ''))).encode())
+        for path in libraries:
+            h.update(('library %s %s\n' % (os.path.basename(path), self._build_id(path))).encode())
+        for name in spec.get('inputs', []):
+            if options.get(name):
+                h.update(('input %s %s\n' % (name, file_digest(options[name]))).encode())
+        return h.hexdigest()
+
+    def _entry_path(self, key):
+        return os.path.join(self.directory, key[:2], key + '.json')
+
+    def _blob_path(self, digest):
+        return os.path.join(self.directory, 'blobs', digest[:2], digest)
+
+    def _store_blob(self, data):
+        digest = hashlib.sha256(data).hexdigest()
+        path = self._blob_path(digest)
+        if not os.path.exists(path):
+            self._write_atomic(path, data)
+        return digest
+
+    @staticmethod
+    def _write_atomic(path, data):
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        fd, tmp = tempfile.mkstemp(dir=os.path.dirname(path))
+        with os.fdopen(fd, 'wb') as f:
+            f.write(data)
+        os.replace(tmp, path)
+
+    def get(self, key):
+        try:
+            with open(self._entry_path(key)) as f:
+                return json.load(f)
+        except (OSError, ValueError):
+            return None
+
+    def restore(self, entry):
+        for name, digest in entry['files'].items():
+            with open(self._blob_path(digest), 'rb') as f:
+                data = f.read()
+            with open(name, 'wb') as f:
+                f.write(data)
+        for name, blobs in entry['appended'].items():
+            data = b''
+            if blobs['header'] and not os.path.exists(name):
+                with open(self._blob_path(blobs['header']), 'rb') as f:
+                    data = f.read()
+            with open(self._blob_path(blobs['rows']), 'rb') as f:
+                data += f.read()
+            with open(name, 'ab') as f:
+                f.write(data)
+
+    def run(self, program, args, binary=None, command=DEFAULT_COMMAND):
+        """stdout of PROGRAM ARGS - from the store if the same run was done with the same binary"""
+        options = parse_args(args)
+        binary = binary or find_binary(program)
+        key = self.key(program, options, binary)
+        if key is None:
+            print('%s: ns-3 libraries not located, run not cached' % binary, file=sys.stderr)
+        entry = self.get(key) if key is not None else None
+        if entry is not None:
+            self.restore(entry)
+            return entry['stdout'], True
+
+        spec = PROGRAMS.get(program, {})
+        appends = {}
+        for name, (pattern, default) in spec.get('appends', {}).items():
+            path = pattern % options.get(name, default)
+            appends[path] = os.path.getsize(path) if os.path.exists(path) else None
+
+        start = time.time()
+        cmd = shlex.split(command.format(program=program, args=' '.join(args)))
+        proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+        if proc.returncode != 0:
+            raise RuntimeError('exit code %d: %s' % (proc.returncode, proc.stderr.strip().splitlines()[-1:]))
+
+        entry = {'program': program, 'args': canonical_args(options), 'stdout': proc.stdout,
+                 'wall': time.time() - start, 'files': {}, 'appended': {}}
+        for name in spec.get('outputs', []):
+            prefix = options.get(name)
+            for path in glob.glob(glob.escape(prefix) + '*') if prefix else []:
+                if os.path.getmtime(path) >= start - 1:
+                    with open(path, 'rb') as f:
+                        entry['files'][path] = self._store_blob(f.read())
+        for path, size in appends.items():
+            if os.path.exists(path):
+                with open(path, 'rb') as f:
+                    data = f.read()
+                header = b''
+                if size is None:  # file created by the run - keep its header line apart
+                    header, _, data = data.partition(b'\n')
+                    header += b'\n'
+                    size = 0
+                entry['appended'][path] = {'rows': self._store_blob(data[size:]),
+                                           'header': self._store_blob(header) if header else None}
+
+        if key is not None:
+            self._write_atomic(self._entry_path(key), json.dumps(entry, sort_keys=True).encode())
+        return proc.stdout, False
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Run an ns-3 example through the result cache.')
+    parser.add_argument('--cache', default=DEFAULT_CACHE, help='store directory (default: %(default)s)')
+    parser.add_argument('--binary', help='built program, for its build ID and those of its libraries '
+                                         '(default: newest match under build/)')
+    parser.add_argument('--command', default=DEFAULT_COMMAND,
+                        help='command running the program, {program} and {args} are replaced (default: %(default)s)')
+    parser.add_argument('program')
+    options, args = parser.parse_known_args(argv[1:])
+
+    stdout, hit = ResultCache(options.cache).run(options.program, args, options.binary, options.command)
+    sys.stdout.write(stdout)
+    print('(cached)' if hit else '(stored)', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,186 @@
+#! /usr/bin/env python3
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+
+# Decoder of the binary packet event trace written by wifi_jows_2_new (--eventTrace=...). See EventTracer
+# in wifi_jows_2_new.cc for the layout. The delay of every packet is split into
+#
+#   queueing  enqueue -> head of its queue: max(enqueue, end of service of the previous packet of the queue)
+#   access    head of the queue -> first transmission attempt (AIFS, backoff, deferral)
+#   air       first attempt -> ACK of the transmitter (RX of the receiver if no ACK event), incl. retries
+#
+# The EDCA function dequeues an MPDU when it gets channel access and holds it through all retries, so the
+# DEQUEUE event does not end the service of a packet - its ACK or DROP does. If neither was recorded (no
+# TxOkHeader trace, or lost from the ring), the service ends with its last transmission or RX, once the
+# next packet of the queue is transmitted.
+#
+#   ./wifi_jows_events.py summary trace.wje        per-TID breakdown (mean, p50, p99 in ms)
+#   ./wifi_jows_events.py packets trace.wje        one CSV row per packet
+#   ./wifi_jows_events.py dump    trace.wje        the raw records
+
+import collections
+import struct
+import sys
+
+HEADER = struct.Struct('<4sHHIIQ40x')
+RECORD = struct.Struct('<qQIIHBBB3x')
+
+ENQUEUE, DEQUEUE, DROP, TX, ACK, RX = range(6)
+EVENT_NAMES = ('ENQUEUE', 'DEQUEUE', 'DROP', 'TX', 'ACK', 'RX')
+QUEUE_NAMES = ('Queue', 'HiTidQueue', 'LowTidQueue')
+TID_NAMES = {7: 'A_VO', 6: 'VO', 5: 'VI', 4: 'A_VI', 0: 'BE', 1: 'BK'}
+# queue of the AltEDCA EDCA function holding a TID (BE_Txop serves TIDs 0 and 3, BK_Txop 1 and 2)
+TID_QUEUE = {0: 'BE', 3: 'BE', 1: 'BK', 2: 'BK', 7: 'VO/Hi', 6: 'VO/Low', 5: 'VI/Hi', 4: 'VI/Low'}
+
+
+def records(path):
+    """records in time order - the oldest ones are lost if the ring wrapped"""
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, version, size, capacity, _, written = HEADER.unpack_from(data, 0)
+    if magic != b'WJEV':
+        raise ValueError('%s: not a wifi_jows event trace' % path)
+    if version != 1 or size != RECORD.size:
+        raise ValueError('%s: unsupported version %d (record size %d)' % (path, version, size))
+
+    count = min(written, capacity)
+    first = written % capacity if written > capacity else 0
+    if written > capacity:
+        print('%s: ring wrapped, the first %d events are lost' % (path, written - capacity), file=sys.stderr)
+    for i in range(count):
+        yield RECORD.unpack_from(data, HEADER.size + ((first + i) % capacity) * RECORD.size)
+
+
+class Packet:
+    __slots__ = ('uid', 'node', 'tid', 'size', 'enqueue', 'head', 'first_tx', 'attempts', 'ack', 'rx', 'dropped')
+
+    def __init__(self, uid, node, tid, size, time):
+        self.uid, self.node, self.tid, self.size = uid, node, tid, size
+        self.enqueue = time
+        self.head = self.first_tx = self.ack = self.rx = None
+        self.attempts = 0
+        self.dropped = False
+
+    def end(self):
+        return self.ack if self.ack is not None else self.rx
+
+
+def decode(path):
+    packets = {}
+    queues = collections.defaultdict(collections.OrderedDict)  # (node, queue) -> UIDs not yet served, FIFO order
+    sent = {}  # (node, tid, sequence number) -> UID of the last transmission
+    last_tx = {}  # UID -> time of its last transmission attempt
+
+    def served(p, time):
+        """end of service of p: the next packet of its queue becomes head (not before its own enqueue)"""
+        queue = queues[(p.node, TID_QUEUE[p.tid])]
+        was_head = bool(queue) and next(iter(queue)) == p.uid
+        queue.pop(p.uid, None)
+        if was_head and queue:
+            following = packets[next(iter(queue))]
+            if following.head is None:
+                following.head = max(following.enqueue, time)
+
+    for time, uid, node, size, sequence, tid, _, event in records(path):
+        if event == ENQUEUE:
+            p = packets[uid] = Packet(uid, node, tid, size, time)
+            queue = queues[(node, TID_QUEUE[tid])]
+            if not queue:
+                p.head = time
+            queue[uid] = None
+        elif event == DROP:
+            p = packets.get(uid)
+            if p is not None:
+                p.dropped = True
+                served(p, time)
+        elif event == TX:
+            p = packets.get(uid)
+            if p is None:  # enqueued before the start of the ring
+                continue
+            if p.first_tx is None:
+                p.first_tx = time
+                # packets still ahead of it were served without a recorded ACK or DROP
+                queue = queues[(node, TID_QUEUE[tid])]
+                while uid in queue and next(iter(queue)) != uid:
+                    previous = packets[next(iter(queue))]
+                    served(previous, max(t for t in (last_tx.get(previous.uid), previous.rx, previous.enqueue)
+                                         if t is not None))
+            p.attempts += 1
+            last_tx[uid] = time
+            sent[(node, tid, sequence)] = uid
+        elif event == ACK:
+            p = packets.get(sent.get((node, tid, sequence)))
+            if p is not None and p.ack is None:
+                p.ack = time
+                served(p, time)
+        elif event == RX:
+            p = packets.get(uid)
+            if p is not None and p.rx is None:
+                p.rx = time
+
+    return packets
+
+
+def stats(values):
+    if not values:
+        return '---'
+    values = sorted(values)
+
+    def pct(q):
+        return values[min(len(values) - 1, max(0, int(q * len(values) + 0.5) - 1))] / 1e6
+
+    return '%.3f / %.3f / %.3f' % (sum(values) / len(values) / 1e6, pct(0.5), pct(0.99))
+
+
+def print_summary(packets):
+    by_tid = collections.defaultdict(list)
+    for p in packets.values():
+        by_tid[p.tid].append(p)
+
+    for tid in sorted(by_tid, reverse=True):
+        group = by_tid[tid]
+        done = [p for p in group if p.head is not None and p.first_tx is not None and p.end() is not None]
+        print('=======================TID: %d (%s) =====================================' % (tid, TID_NAMES.get(tid, '?')))
+        print('  Enqueued:\t%d' % len(group))
+        print('  Delivered:\t%d' % len(done))
+        print('  Dropped:\t%d' % sum(1 for p in group if p.dropped))
+        print('  Attempts:\t%.3f per delivered packet' % (sum(p.attempts for p in done) / len(done) if done else 0))
+        print('  (mean / p50 / p99 [ms])')
+        print('  Queueing:\t%s' % stats([p.head - p.enqueue for p in done]))
+        print('  Access:\t%s' % stats([p.first_tx - p.head for p in done]))
+        print('  Air:\t%s' % stats([p.end() - p.first_tx for p in done]))
+        print('  Total:\t%s' % stats([p.end() - p.enqueue for p in done]))
+
+
+def print_packets(packets):
+    print('uid,node,tid,size,enqueue,head,firstTx,attempts,ack,rx,dropped,queueingNs,accessNs,airNs')
+    for p in sorted(packets.values(), key=lambda p: p.enqueue):
+        def diff(a, b):
+            return '' if a is None or b is None else str(a - b)
+
+        print(','.join(str(v) for v in (
+            p.uid, p.node, p.tid, p.size, p.enqueue, '' if p.head is None else p.head,
+            '' if p.first_tx is None else p.first_tx, p.attempts, '' if p.ack is None else p.ack,
+            '' if p.rx is None else p.rx, int(p.dropped),
+            diff(p.head, p.enqueue), diff(p.first_tx, p.head), diff(p.end(), p.first_tx))))
+
+
+def print_dump(path):
+    print('time,uid,node,size,sequence,tid,queue,event')
+    for time, uid, node, size, sequence, tid, queue, event in records(path):
+        print('%d,%d,%d,%d,%d,%d,%s,%s' % (time, uid, node, size, sequence, tid, QUEUE_NAMES[queue], EVENT_NAMES[event]))
+
+
+def main(argv):
+    if len(argv) != 3 or argv[1] not in ('summary', 'packets', 'dump'):
+        sys.exit('usage: wifi_jows_events.py summary|packets|dump FILE')
+
+    if argv[1] == 'summary':
+        print_summary(decode(argv[2]))
+    elif argv[1] == 'packets':
+        print_packets(decode(argv[2]))
+    else:
+        print_dump(argv[2])
+
+
+if __name__ == '__main__':
+    main(sys.argv)
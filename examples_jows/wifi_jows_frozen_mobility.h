@@ -0,0 +1,96 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 AGH University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as 
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+//Model of wifi_jows_2_new, registered with the TypeId system. Definitions included - the header is included once,
+//by the program (a single-file program in scratch/: the headers next to it are not built on their own).
+
+#ifndef WIFI_JOWS_FROZEN_MOBILITY_H
+#define WIFI_JOWS_FROZEN_MOBILITY_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+//position of a node that never moves: GetPosition/GetDistanceFrom only read the stored vector (no velocity integration
+//as in ConstantVelocityMobilityModel); counts its position queries (summed over the nodes by perfReport)
+class FrozenPositionMobilityModel : public MobilityModel
+{
+public:
+  static TypeId GetTypeId (void);
+  FrozenPositionMobilityModel ();
+
+  uint64_t GetQueries (void) const;
+
+private:
+  virtual Vector DoGetPosition (void) const;
+  virtual void DoSetPosition (const Vector &position);
+  virtual Vector DoGetVelocity (void) const;
+
+  Vector m_position;
+  mutable uint64_t m_queries;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (FrozenPositionMobilityModel);
+
+TypeId
+FrozenPositionMobilityModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FrozenPositionMobilityModel")
+    .SetParent<MobilityModel> ()
+    .AddConstructor<FrozenPositionMobilityModel> ()
+  ;
+  return tid;
+}
+
+FrozenPositionMobilityModel::FrozenPositionMobilityModel ()
+  : m_queries (0)
+{
+}
+
+uint64_t
+FrozenPositionMobilityModel::GetQueries (void) const
+{
+  return m_queries;
+}
+
+Vector
+FrozenPositionMobilityModel::DoGetPosition (void) const
+{
+  m_queries++;
+  return m_position;
+}
+
+void
+FrozenPositionMobilityModel::DoSetPosition (const Vector &position)
+{
+  m_position = position;
+  NotifyCourseChange ();
+}
+
+Vector
+FrozenPositionMobilityModel::DoGetVelocity (void) const
+{
+  return Vector (0.0, 0.0, 0.0);
+}
+
+} // namespace ns3
+
+#endif /* WIFI_JOWS_FROZEN_MOBILITY_H */
@@ -0,0 +1,356 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 AGH University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as 
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+//Model of wifi_jows_2_new, registered with the TypeId system. Definitions included - the header is included once,
+//by the program (a single-file program in scratch/: the headers next to it are not built on their own).
+//
+//ReceiverGrid::Send and ReceiverGrid::Receive re-implement YansWifiChannel::Send and YansWifiChannel::Receive of
+//ns-3.33 (src/wifi/model/yans-wifi-channel.cc) - the same checks (same channel number, RxSensitivity after RxGain),
+//the same receiver context (node id, 0xffffffff without a device), a copy of the PPDU per receiver, the dummy band of
+//YANS and the same scheduling order. Compare them with that file when moving to another ns-3 release.
+
+#ifndef WIFI_JOWS_GRID_CHANNEL_H
+#define WIFI_JOWS_GRID_CHANNEL_H
+
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-ppdu.h"
+#include "ns3/wifi-utils.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "wifi_jows_loss_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+//spatial index of the YansWifiPhys of one channel (aggregated to the YansWifiChannel) - a transmission is delivered only
+//to PHYs in the grid cells around the sender: cell size = distance at which the strongest transmitter falls below the
+//lowest RxSensitivity, below which YansWifiChannel::Receive drops the signal anyway (not even counted as interference),
+//so the simulated events are the same; only used for deterministic distance-based loss models, else full fan-out
+class ReceiverGrid : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+  ReceiverGrid ();
+
+  void Send (Ptr<YansWifiPhy> sender, Ptr<WifiPpdu> ppdu, double txPowerDbm);
+  uint64_t GetDelivered (void) const;
+  uint64_t GetCulled (void) const;
+
+private:
+  void Build (void);
+  bool IsDeterministic (Ptr<PropagationLossModel> loss) const;
+  uint64_t CellKey (const Vector &position) const;
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+  static void Receive (Ptr<YansWifiPhy> phy, Ptr<WifiPpdu> ppdu, double rxPowerDbm);
+
+  std::vector<Ptr<YansWifiPhy> > m_phys;                   //in the order of the channel (same event order as YansWifiChannel::Send)
+  std::map<const MobilityModel *, uint32_t> m_index;
+  std::unordered_map<uint64_t, std::vector<uint32_t> > m_cells;
+  std::vector<uint64_t> m_cellOf;                          //cell of every PHY
+  std::set<uint32_t> m_moving;                             //PHYs with non-zero velocity - always checked
+  std::set<const MobilityModel *> m_connected;             //CourseChange connected (kept over rebuilds)
+  Ptr<PropagationLossModel> m_loss;
+  Ptr<PropagationDelayModel> m_delay;
+  double m_range;                                          //[m] (0 - culling off)
+  uint64_t m_delivered;
+  uint64_t m_culled;
+  std::vector<uint32_t> m_candidates;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (ReceiverGrid);
+
+TypeId
+ReceiverGrid::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReceiverGrid")
+    .SetParent<Object> ()
+    .AddConstructor<ReceiverGrid> ()
+  ;
+  return tid;
+}
+
+ReceiverGrid::ReceiverGrid ()
+  : m_range (0),
+    m_delivered (0),
+    m_culled (0)
+{
+}
+
+uint64_t
+ReceiverGrid::GetDelivered (void) const
+{
+  return m_delivered;
+}
+
+uint64_t
+ReceiverGrid::GetCulled (void) const
+{
+  return m_culled;
+}
+
+//loss models whose result depends on the distance only, without randomness
+bool
+ReceiverGrid::IsDeterministic (Ptr<PropagationLossModel> loss) const
+{
+  static const char *models[] = { "ns3::LogDistancePropagationLossModel", "ns3::ThreeLogDistancePropagationLossModel",
+                                  "ns3::FriisPropagationLossModel", "ns3::TwoRayGroundPropagationLossModel",
+                                  "ns3::RangePropagationLossModel" };
+  for (; loss != 0; loss = loss->GetNext ())
+    {
+      Ptr<CachedPropagationLossModel> cached = DynamicCast<CachedPropagationLossModel> (loss);
+      if (cached != 0)
+        {
+          if (!IsDeterministic (cached->GetModel ()))
+            return false;
+          continue;
+        }
+      bool known = false;
+      for (uint8_t m = 0; m < 5; m++)
+        known = known || (loss->GetInstanceTypeId ().GetName () == models[m]);
+      if (!known)
+        return false;
+    }
+  return true;
+}
+
+//built on the first transmission - all devices are attached to the channel by then
+void
+ReceiverGrid::Build (void)
+{
+  Ptr<YansWifiChannel> channel = GetObject<YansWifiChannel> ();
+  PointerValue ptr;
+  channel->GetAttribute ("PropagationLossModel", ptr);
+  m_loss = ptr.Get<PropagationLossModel> ();
+  channel->GetAttribute ("PropagationDelayModel", ptr);
+  m_delay = ptr.Get<PropagationDelayModel> ();
+
+  double txPowerDbm = -1000, thresholdDbm = 1000;
+  m_phys.clear ();
+  for (uint32_t i = 0; i < channel->GetNDevices (); i++)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (channel->GetDevice (i));
+      Ptr<YansWifiPhy> phy = DynamicCast<YansWifiPhy> (device->GetPhy ());
+      m_phys.push_back (phy);
+      txPowerDbm = std::max (txPowerDbm, std::max (phy->GetTxPowerStart (), phy->GetTxPowerEnd ()) + phy->GetTxGain ());
+      thresholdDbm = std::min (thresholdDbm, phy->GetRxSensitivity () - phy->GetRxGain ());
+    }
+
+  //largest distance still above the threshold (bisection - the allowed models are monotonic in distance)
+  m_range = 0;
+  if (IsDeterministic (m_loss))
+    {
+      Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+      Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+      double low = 0, high = 1e6;
+      b->SetPosition (Vector (high, 0, 0));
+      if (m_loss->CalcRxPower (txPowerDbm, a, b) < thresholdDbm)
+        {
+          while (high - low > 0.01)
+            {
+              double middle = (low + high) / 2;
+              b->SetPosition (Vector (middle, 0, 0));
+              if (m_loss->CalcRxPower (txPowerDbm, a, b) >= thresholdDbm)
+                low = middle;
+              else
+                high = middle;
+            }
+          m_range = high + 1.0; //margin for rounding
+        }
+    }
+  if (m_range == 0)
+    std::cout << "(gridChannel: loss model not bounded by distance - every PHY receives every frame)" << std::endl;
+
+  m_cells.clear ();
+  m_index.clear ();
+  m_moving.clear ();
+  m_cellOf.assign (m_phys.size (), 0);
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phys[i]->GetMobility ();
+      m_index[PeekPointer (mobility)] = i;
+      if (m_connected.insert (PeekPointer (mobility)).second) //rebuilt when devices are added - connect new PHYs only
+        mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&ReceiverGrid::CourseChanged, this));
+      m_cellOf[i] = CellKey (mobility->GetPosition ());
+      m_cells[m_cellOf[i]].push_back (i);
+      Vector velocity = mobility->GetVelocity ();
+      if ((velocity.x != 0) || (velocity.y != 0) || (velocity.z != 0))
+        m_moving.insert (i);
+    }
+}
+
+uint64_t
+ReceiverGrid::CellKey (const Vector &position) const
+{
+  if (m_range == 0)
+    return 0;
+  uint64_t x = (int64_t) std::floor (position.x / m_range) & 0x1fffff;
+  uint64_t y = (int64_t) std::floor (position.y / m_range) & 0x1fffff;
+  uint64_t z = (int64_t) std::floor (position.z / m_range) & 0x1fffff;
+  return (x << 42) | (y << 21) | z;
+}
+
+//positions only change on course changes, except for moving nodes (kept out of the grid)
+void
+ReceiverGrid::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  std::map<const MobilityModel *, uint32_t>::iterator it = m_index.find (PeekPointer (mobility));
+  if (it == m_index.end ())
+    return;
+  uint32_t i = it->second;
+
+  Vector velocity = mobility->GetVelocity ();
+  if ((velocity.x != 0) || (velocity.y != 0) || (velocity.z != 0))
+    m_moving.insert (i);
+  else
+    m_moving.erase (i);
+
+  uint64_t cell = CellKey (mobility->GetPosition ());
+  if (cell == m_cellOf[i])
+    return;
+  std::vector<uint32_t> &old = m_cells[m_cellOf[i]];
+  old.erase (std::find (old.begin (), old.end (), i));
+  std::vector<uint32_t> &cur = m_cells[cell];
+  cur.insert (std::lower_bound (cur.begin (), cur.end (), i), i);
+  m_cellOf[i] = cell;
+}
+
+//YansWifiChannel::Send (ns-3.33) restricted to the PHYs in range
+void
+ReceiverGrid::Send (Ptr<YansWifiPhy> sender, Ptr<WifiPpdu> ppdu, double txPowerDbm)
+{
+  if (m_phys.size () != GetObject<YansWifiChannel> ()->GetNDevices ())
+    Build ();
+
+  Ptr<MobilityModel> senderMobility = sender->GetMobility ();
+  Vector position = senderMobility->GetPosition ();
+
+  m_candidates.clear ();
+  if (m_range == 0)
+    for (uint32_t i = 0; i < m_phys.size (); i++)
+      m_candidates.push_back (i);
+  else
+    {
+      for (int64_t dx = -1; dx <= 1; dx++)
+        for (int64_t dy = -1; dy <= 1; dy++)
+          for (int64_t dz = -1; dz <= 1; dz++)
+            {
+              Vector neighbour (position.x + dx * m_range, position.y + dy * m_range, position.z + dz * m_range);
+              std::unordered_map<uint64_t, std::vector<uint32_t> >::const_iterator cell = m_cells.find (CellKey (neighbour));
+              if (cell != m_cells.end ())
+                m_candidates.insert (m_candidates.end (), cell->second.begin (), cell->second.end ());
+            }
+      m_candidates.insert (m_candidates.end (), m_moving.begin (), m_moving.end ());
+      std::sort (m_candidates.begin (), m_candidates.end ());
+      m_candidates.erase (std::unique (m_candidates.begin (), m_candidates.end ()), m_candidates.end ());
+    }
+
+  uint32_t delivered = 0;
+  for (uint32_t c = 0; c < m_candidates.size (); c++)
+    {
+      Ptr<YansWifiPhy> receiver = m_phys[m_candidates[c]];
+      if ((receiver == sender) || (receiver->GetChannelNumber () != sender->GetChannelNumber ()))
+        continue;
+      Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+      if ((m_range > 0) && (CalculateDistance (position, receiverMobility->GetPosition ()) > m_range))
+        continue;
+
+      Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+      double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+      Ptr<NetDevice> device = receiver->GetDevice ();
+      uint32_t node = (device == 0) ? 0xffffffff : device->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (node, delay, &ReceiverGrid::Receive, receiver, Copy (ppdu), rxPowerDbm);
+      delivered++;
+    }
+
+  m_delivered += delivered;
+  m_culled += m_phys.size () - 1 - delivered;
+}
+
+//same as YansWifiChannel::Receive of ns-3.33 (private there)
+void
+ReceiverGrid::Receive (Ptr<YansWifiPhy> phy, Ptr<WifiPpdu> ppdu, double rxPowerDbm)
+{
+  if ((rxPowerDbm + phy->GetRxGain ()) < phy->GetRxSensitivity ())
+    return;
+  RxPowerWattPerChannelBand rxPowerW;
+  rxPowerW.insert (std::make_pair (std::make_pair (0, 0), DbmToW (rxPowerDbm + phy->GetRxGain ()))); //dummy band for YANS
+  phy->StartReceivePreamble (ppdu, rxPowerW);
+}
+
+
+
+//YansWifiPhy transmitting through the ReceiverGrid of its channel (YansWifiChannel::Send is not virtual)
+class GridYansWifiPhy : public YansWifiPhy
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual void StartTx (Ptr<WifiPpdu> ppdu);
+};
+
+NS_OBJECT_ENSURE_REGISTERED (GridYansWifiPhy);
+
+TypeId
+GridYansWifiPhy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GridYansWifiPhy")
+    .SetParent<YansWifiPhy> ()
+    .AddConstructor<GridYansWifiPhy> ()
+  ;
+  return tid;
+}
+
+void
+GridYansWifiPhy::StartTx (Ptr<WifiPpdu> ppdu)
+{
+  Ptr<YansWifiChannel> channel = DynamicCast<YansWifiChannel> (GetChannel ());
+  Ptr<ReceiverGrid> grid = channel->GetObject<ReceiverGrid> ();
+  if (grid == 0)
+    {
+      grid = CreateObject<ReceiverGrid> ();
+      channel->AggregateObject (grid);
+    }
+  grid->Send (this, ppdu, GetTxPowerForTransmission (ppdu->GetTxVector ()) + GetTxGain ());
+}
+
+//YansWifiPhyHelper creating GridYansWifiPhys (gridChannel=1)
+class GridYansWifiPhyHelper : public YansWifiPhyHelper
+{
+public:
+  GridYansWifiPhyHelper ()
+  {
+    m_phy.SetTypeId ("ns3::GridYansWifiPhy");
+  }
+};
+
+} // namespace ns3
+
+#endif /* WIFI_JOWS_GRID_CHANNEL_H */
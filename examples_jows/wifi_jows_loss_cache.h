@@ -0,0 +1,171 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 AGH University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as 
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+//Model of wifi_jows_2_new, registered with the TypeId system. Definitions included - the header is included once,
+//by the program (a single-file program in scratch/: the headers next to it are not built on their own).
+
+#ifndef WIFI_JOWS_LOSS_CACHE_H
+#define WIFI_JOWS_LOSS_CACHE_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include <cmath>
+#include <limits>
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+//memoizes the loss of the wrapped (deterministic) loss models per transmitter/receiver node pair in a dense matrix;
+//an entry is recomputed only after a course change of one of the two nodes (pairs with a moving node are not cached);
+//stochastic models (e.g. Nakagami fading) are chained as the next model and evaluated for every frame as before
+class CachedPropagationLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void);
+  CachedPropagationLossModel ();
+
+  void SetModel (Ptr<PropagationLossModel> model);
+  Ptr<PropagationLossModel> GetModel (void) const;
+  uint64_t GetHits (void) const;
+  uint64_t GetMisses (void) const;
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  Ptr<PropagationLossModel> m_model;
+  mutable std::vector<double> m_loss;   //[dB] row - transmitter, column - receiver node id (NaN - not known)
+  mutable size_t m_size;                //nodes covered - NodeList size at the first frame
+  mutable std::set<uint32_t> m_tracked; //nodes with the CourseChange trace connected
+  mutable uint64_t m_hits;
+  mutable uint64_t m_misses;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (CachedPropagationLossModel);
+
+TypeId
+CachedPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .AddConstructor<CachedPropagationLossModel> ()
+  ;
+  return tid;
+}
+
+CachedPropagationLossModel::CachedPropagationLossModel ()
+  : m_size (0),
+    m_hits (0),
+    m_misses (0)
+{
+}
+
+void
+CachedPropagationLossModel::SetModel (Ptr<PropagationLossModel> model)
+{
+  m_model = model;
+}
+
+Ptr<PropagationLossModel>
+CachedPropagationLossModel::GetModel (void) const
+{
+  return m_model;
+}
+
+uint64_t
+CachedPropagationLossModel::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+CachedPropagationLossModel::GetMisses (void) const
+{
+  return m_misses;
+}
+
+double
+CachedPropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  Ptr<Node> tx = a->GetObject<Node> ();
+  Ptr<Node> rx = b->GetObject<Node> ();
+  if ((tx == 0) || (rx == 0)) //mobility models not attached to nodes (e.g. range search of ReceiverGrid)
+    return m_model->CalcRxPower (txPowerDbm, a, b);
+  Vector va = a->GetVelocity (), vb = b->GetVelocity ();
+  if ((va.x != 0) || (va.y != 0) || (va.z != 0) || (vb.x != 0) || (vb.y != 0) || (vb.z != 0)) //moving without course changes
+    return m_model->CalcRxPower (txPowerDbm, a, b);
+
+  if (m_loss.empty ()) //allocated once - all nodes exist when the first frame is sent
+    {
+      m_size = NodeList::GetNNodes ();
+      m_loss.assign (m_size * m_size, std::numeric_limits<double>::quiet_NaN ());
+    }
+  size_t i = tx->GetId (), j = rx->GetId ();
+  if (std::max (i, j) >= m_size) //node created during the run - not cached
+    return m_model->CalcRxPower (txPowerDbm, a, b);
+
+  double &loss = m_loss[i * m_size + j];
+  if (std::isnan (loss))
+    {
+      for (uint8_t k = 0; k < 2; k++)
+        {
+          Ptr<MobilityModel> mobility = (k == 0) ? a : b;
+          uint32_t id = (k == 0) ? i : j;
+          if (m_tracked.insert (id).second)
+            mobility->TraceConnectWithoutContext ("CourseChange",
+              MakeCallback (&CachedPropagationLossModel::CourseChanged, const_cast<CachedPropagationLossModel *> (this)));
+        }
+      loss = txPowerDbm - m_model->CalcRxPower (txPowerDbm, a, b);
+      m_misses++;
+    }
+  else
+    m_hits++;
+
+  return txPowerDbm - loss;
+}
+
+//forget the losses from and to the node that moved
+void
+CachedPropagationLossModel::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  Ptr<Node> node = mobility->GetObject<Node> ();
+  if ((node == 0) || (node->GetId () >= m_size))
+    return;
+  size_t id = node->GetId ();
+  for (size_t k = 0; k < m_size; k++)
+    {
+      m_loss[id * m_size + k] = std::numeric_limits<double>::quiet_NaN ();
+      m_loss[k * m_size + id] = std::numeric_limits<double>::quiet_NaN ();
+    }
+}
+
+int64_t
+CachedPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  return m_model->AssignStreams (stream);
+}
+
+} // namespace ns3
+
+#endif /* WIFI_JOWS_LOSS_CACHE_H */
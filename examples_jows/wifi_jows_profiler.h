@@ -0,0 +1,220 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2016 AGH University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as 
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+//Model of wifi_jows_2_new, registered with the TypeId system. Definitions included - the header is included once,
+//by the program (a single-file program in scratch/: the headers next to it are not built on their own).
+
+#ifndef WIFI_JOWS_PROFILER_H
+#define WIFI_JOWS_PROFILER_H
+
+#include "ns3/default-simulator-impl.h"
+#include "ns3/event-impl.h"
+#include "ns3/uinteger.h"
+#include <cxxabi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+//DefaultSimulatorImpl that charges the events executed and their wall time to the scheduled callback target
+//(type of the EventImpl - e.g. the member function type of MakeEvent, like void (ns3::Txop::*)()); prints the
+//top-N targets once, at Simulator::Destroy (a run may be made of several Run calls - warm-up and continuation of the
+//variants). Selected only by profile=N (SimulatorImplementationType), so it costs nothing otherwise
+class ProfilingSimulatorImpl : public DefaultSimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+  ProfilingSimulatorImpl ();
+
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual void Destroy (void);
+
+  void Reset (void); //forked variant - only the events after the branch are its own
+
+private:
+  struct Target
+  {
+    Target () : events (0), wall (0) {}
+    uint64_t events;
+    int64_t wall; //[ns]
+  };
+
+  //runs the original event and charges it to its target
+  class ProfiledEvent : public EventImpl
+  {
+  public:
+    ProfiledEvent (EventImpl *event, Target *target);
+  protected:
+    virtual void Notify (void);
+  private:
+    Ptr<EventImpl> m_event;
+    Target *m_target;
+  };
+
+  EventImpl *Wrap (EventImpl *event);
+  static std::string Label (const char *mangled);
+  void PrintTable (void) const;
+
+  std::unordered_map<const char *, Target> m_targets; //by type name (one string per type)
+  uint32_t m_topN;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (ProfilingSimulatorImpl);
+
+TypeId
+ProfilingSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ProfilingSimulatorImpl")
+    .SetParent<DefaultSimulatorImpl> ()
+    .AddConstructor<ProfilingSimulatorImpl> ()
+    .AddAttribute ("TopN", "Number of callback targets printed at Simulator::Destroy.",
+                   UintegerValue (20),
+                   MakeUintegerAccessor (&ProfilingSimulatorImpl::m_topN),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+ProfilingSimulatorImpl::ProfilingSimulatorImpl ()
+  : m_topN (20)
+{
+}
+
+ProfilingSimulatorImpl::ProfiledEvent::ProfiledEvent (EventImpl *event, Target *target)
+  : m_event (event, false),
+    m_target (target)
+{
+}
+
+void
+ProfilingSimulatorImpl::ProfiledEvent::Notify (void)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  m_event->Invoke ();
+  m_target->wall += std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - start).count ();
+  m_target->events++;
+}
+
+//the target is looked up once, when the event is scheduled
+EventImpl *
+ProfilingSimulatorImpl::Wrap (EventImpl *event)
+{
+  return new ProfiledEvent (event, &m_targets[typeid (*event).name ()]);
+}
+
+EventId
+ProfilingSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  return DefaultSimulatorImpl::Schedule (delay, Wrap (event));
+}
+
+void
+ProfilingSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  DefaultSimulatorImpl::ScheduleWithContext (context, delay, Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return DefaultSimulatorImpl::ScheduleNow (Wrap (event));
+}
+
+void
+ProfilingSimulatorImpl::Destroy (void)
+{
+  PrintTable ();
+  DefaultSimulatorImpl::Destroy ();
+}
+
+//the targets are kept - events already scheduled hold pointers to them
+void
+ProfilingSimulatorImpl::Reset (void)
+{
+  for (std::unordered_map<const char *, Target>::iterator t = m_targets.begin (); t != m_targets.end (); t++)
+    t->second = Target ();
+}
+
+//"ns3::MakeEvent<void (ns3::Txop::*)(), ns3::Txop*>(...)::EventMemberImpl0" -> "void (ns3::Txop::*)(), ns3::Txop*"
+std::string
+ProfilingSimulatorImpl::Label (const char *mangled)
+{
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, 0, 0, &status);
+  std::string name = (status == 0) ? demangled : mangled;
+  std::free (demangled);
+
+  std::string prefix = "ns3::MakeEvent<";
+  if (name.compare (0, prefix.size (), prefix) != 0)
+    return name;
+  int depth = 1;
+  for (size_t i = prefix.size (); i < name.size (); i++)
+    {
+      if (name[i] == '<')
+        depth++;
+      else if ((name[i] == '>') && (--depth == 0))
+        return name.substr (prefix.size (), i - prefix.size ());
+    }
+  return name;
+}
+
+void
+ProfilingSimulatorImpl::PrintTable (void) const
+{
+  std::vector<std::pair<int64_t, const char *> > order;
+  uint64_t events = 0;
+  int64_t wall = 0;
+  for (std::unordered_map<const char *, Target>::const_iterator t = m_targets.begin (); t != m_targets.end (); t++)
+    {
+      order.push_back (std::make_pair (t->second.wall, t->first));
+      events += t->second.events;
+      wall += t->second.wall;
+    }
+  std::sort (order.rbegin (), order.rend ());
+
+  std::ostringstream out;
+  out << "=======================Event profile: =============================" << std::endl;
+  out << "  events\t%events\twall [ms]\t%wall\tns/event\ttarget" << std::endl;
+  for (uint32_t i = 0; (i < order.size ()) && (i < m_topN); i++)
+    {
+      const Target &t = m_targets.at (order[i].second);
+      if (t.events == 0)
+        continue;
+      out << "  " << t.events << "\t" << 100.0 * t.events / std::max<uint64_t> (events, 1)
+          << "\t" << t.wall / 1e6 << "\t" << 100.0 * t.wall / std::max<int64_t> (wall, 1)
+          << "\t" << t.wall / t.events << "\t" << Label (order[i].second) << std::endl;
+    }
+  out << "  " << events << "\t100\t" << wall / 1e6 << "\t100\t" << (events > 0 ? wall / (int64_t) events : 0)
+      << "\t(all " << m_targets.size () << " targets)" << std::endl;
+  std::cout << out.str () << std::flush;
+}
+
+} // namespace ns3
+
+#endif /* WIFI_JOWS_PROFILER_H */
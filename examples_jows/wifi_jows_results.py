@@ -0,0 +1,196 @@
+#! /usr/bin/env python3
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+
+# Reader / converter for the binary results files written by wifi_jows_2_new
+# (--resultsFile=...). See WriteBinaryResults in wifi_jows_2_new.cc for the layout.
+#
+#   ./wifi_jows_results.py tid  out.wjr            per-TID summary
+#   ./wifi_jows_results.py csv  out.wjr [...]      one CSV row per flow (several files may be given)
+#   ./wifi_jows_results.py hist out.wjr FLOWID [delay|jitter|size|latency]
+#                                                  non-empty histogram bins of one flow
+#   ./wifi_jows_results.py latency out.wjr TID     non-empty latency histogram bins of one TID
+
+import struct
+import sys
+
+HEADER = struct.Struct('<4sHHIIIIIIddddd')
+LATENCY_LAYOUT = struct.Struct('<II')  # version 2 header tail
+STOP_LAYOUT = struct.Struct('<d')  # version 3 header tail (after LATENCY_LAYOUT)
+TID = {1: struct.Struct('<QQQQQdqq'), 2: struct.Struct('<QQQQQdqqdddI')}
+TID[3] = TID[2]
+FLOW = {1: struct.Struct('<IIIHHBBHIIIIIIIQQqqqqqq'), 2: struct.Struct('<IIIHHBBHIIIIIIIQQqqqqqqdddI')}
+FLOW[3] = FLOW[2]
+PERCENTILES = ('delayP50', 'delayP99', 'delayP999', 'nLatencyBins')
+
+TID_NAMES = {7: 'A_VO', 6: 'VO', 5: 'VI', 4: 'A_VI', 0: 'BE', 1: 'BK'}
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7f) << shift
+        if b < 0x80:
+            return value, pos
+        shift += 7
+
+
+def read_bins(data, pos, count):
+    bins = []
+    index = 0
+    for _ in range(count):
+        delta, pos = read_varint(data, pos)
+        n, pos = read_varint(data, pos)
+        index += delta
+        bins.append((index, n))
+    return bins, pos
+
+
+def latency_bucket(index, sub_buckets):
+    """[lower, lower + width) of a LatencyHistogram bucket, in latency units"""
+    if index < 2 * sub_buckets:
+        return index, 1
+    shift = index // sub_buckets - 1
+    return (index % sub_buckets + sub_buckets) << shift, 1 << shift
+
+
+def ipv4(addr):
+    return '.'.join(str((addr >> s) & 0xff) for s in (24, 16, 8, 0))
+
+
+def load(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    h = HEADER.unpack_from(data, 0)
+    if h[0] != b'WJRS':
+        raise ValueError('%s: not a wifi_jows results file' % path)
+    version = h[1]
+    if version not in (1, 2, 3):
+        raise ValueError('%s: unsupported version %d' % (path, version))
+
+    res = {
+        'file': path,
+        'nTids': h[3], 'nFlows': h[4], 'seed': h[5], 'run': h[6], 'nSTA': h[7], 'packetSize': h[8],
+        'simTime': h[9], 'calcStart': h[10], 'stopTime': h[9],
+        'binWidth': {'delay': h[11], 'jitter': h[12], 'size': h[13]},
+        'version': version, 'latencyUnit': 0, 'latencySubBuckets': 0,
+        'tids': [], 'flows': [],
+    }
+    if version >= 2:
+        res['latencyUnit'], res['latencySubBuckets'] = LATENCY_LAYOUT.unpack_from(data, HEADER.size)
+    if version >= 3:  # older files: the run is assumed to have lasted until simTime
+        res['stopTime'], = STOP_LAYOUT.unpack_from(data, HEADER.size + LATENCY_LAYOUT.size)
+    extra = PERCENTILES if version >= 2 else ()
+
+    pos = h[2]
+    for tid in range(res['nTids']):
+        t = TID[version].unpack_from(data, pos)
+        pos += TID[version].size
+        res['tids'].append(dict(zip(('txBytes', 'rxBytes', 'txPackets', 'rxPackets', 'lostPackets',
+                                     'throughput', 'delaySum', 'jitterSum') + extra, t)))
+
+    for _ in range(res['nFlows']):
+        f = FLOW[version].unpack_from(data, pos)
+        pos += FLOW[version].size
+        res['flows'].append(dict(zip(('flowId', 'srcAddr', 'dstAddr', 'srcPort', 'dstPort', 'protocol', 'tid',
+                                      'nDropReasons', 'txPackets', 'rxPackets', 'lostPackets', 'timesForwarded',
+                                      'nDelayBins', 'nJitterBins', 'nSizeBins', 'txBytes', 'rxBytes',
+                                      'delaySum', 'jitterSum', 'timeFirstTx', 'timeFirstRx', 'timeLastTx',
+                                      'timeLastRx') + extra, f)))
+
+    for t in res['tids']:
+        t['latency'], pos = read_bins(data, pos, t.get('nLatencyBins', 0))
+
+    for f in res['flows']:
+        f['delay'], pos = read_bins(data, pos, f['nDelayBins'])
+        f['jitter'], pos = read_bins(data, pos, f['nJitterBins'])
+        f['size'], pos = read_bins(data, pos, f['nSizeBins'])
+        f['latency'], pos = read_bins(data, pos, f.get('nLatencyBins', 0))
+        f['dropped'] = {}
+        for _ in range(f['nDropReasons']):
+            reason, pos = read_varint(data, pos)
+            packets, pos = read_varint(data, pos)
+            nbytes, pos = read_varint(data, pos)
+            f['dropped'][reason] = (packets, nbytes)
+
+    return res
+
+
+def mean_ms(total_ns, n):
+    return '%.3f' % (total_ns / n / 1e6) if n > 0 else '---'
+
+
+def print_tids(res):
+    for tid, t in enumerate(res['tids']):
+        if tid not in TID_NAMES:
+            continue
+        print('=======================TID: %d (%s) =====================================' % (tid, TID_NAMES[tid]))
+        print('  Tx bytes:\t%d' % t['txBytes'])
+        print('  Rx bytes:\t%d' % t['rxBytes'])
+        print('  Tx packets:\t%d' % t['txPackets'])
+        print('  Rx packets:\t%d' % t['rxPackets'])
+        print('  Lost packets:\t%d' % t['lostPackets'])
+        print('  Throughput:\t%g Mb/s' % t['throughput'])
+        for label, total, n in (('Mean delay', t['delaySum'], t['rxPackets']),
+                                ('Mean jitter', t['jitterSum'], t['rxPackets'] - 1)):
+            print('  %s:\t%s' % (label, mean_ms(total, n) + ' ms' if n > 0 else '---'))
+            if label == 'Mean delay' and 'delayP50' in t and n > 0:
+                print('  Delay p50:\t%g ms' % t['delayP50'])
+                print('  Delay p99:\t%g ms' % t['delayP99'])
+                print('  Delay p99.9:\t%g ms' % t['delayP999'])
+
+
+def print_csv(results):
+    print('file,seed,run,flowId,src,srcPort,dst,dstPort,tid,txBytes,rxBytes,txPackets,rxPackets,lostPackets,'
+          'throughputMbps,meanDelayMs,meanJitterMs,delayP50Ms,delayP99Ms,delayP999Ms')
+    for res in results:
+        period = res['stopTime'] - res['calcStart']
+        for f in res['flows']:
+            print(','.join(str(v) for v in (
+                res['file'], res['seed'], res['run'], f['flowId'], ipv4(f['srcAddr']), f['srcPort'],
+                ipv4(f['dstAddr']), f['dstPort'], f['tid'], f['txBytes'], f['rxBytes'], f['txPackets'],
+                f['rxPackets'], f['lostPackets'], '%g' % (f['rxBytes'] * 8.0 / period / 1e6),
+                mean_ms(f['delaySum'], f['rxPackets']), mean_ms(f['jitterSum'], f['rxPackets'] - 1),
+                *(('%g' % f[p]) if p in f else '' for p in PERCENTILES[:3]))))
+
+
+def print_bins(res, kind, bins):
+    print('index,start,width,count')
+    for index, count in bins:
+        if kind == 'latency':  # log buckets, in seconds as the FlowMonitor histograms
+            lower, width = latency_bucket(index, res['latencySubBuckets'])
+            unit = res['latencyUnit'] * 1e-9
+            print('%d,%g,%g,%d' % (index, lower * unit, width * unit, count))
+        else:
+            width = res['binWidth'][kind]
+            print('%d,%g,%g,%d' % (index, index * width, width, count))
+
+
+def print_hist(res, flow_id, kind):
+    for f in res['flows']:
+        if f['flowId'] == flow_id:
+            print_bins(res, kind, f[kind])
+            return
+    sys.exit('flow %d not found' % flow_id)
+
+
+def main(argv):
+    if len(argv) < 3 or argv[1] not in ('tid', 'csv', 'hist', 'latency'):
+        sys.exit('usage: wifi_jows_results.py tid|csv|hist|latency FILE [...]')
+
+    if argv[1] == 'tid':
+        print_tids(load(argv[2]))
+    elif argv[1] == 'csv':
+        print_csv([load(p) for p in argv[2:]])
+    elif argv[1] == 'latency':
+        res = load(argv[2])
+        print_bins(res, 'latency', res['tids'][int(argv[3])]['latency'])
+    else:
+        print_hist(load(argv[2]), int(argv[3]), argv[4] if len(argv) > 4 else 'delay')
+
+
+if __name__ == '__main__':
+    main(sys.argv)
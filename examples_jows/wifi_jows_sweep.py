@@ -0,0 +1,221 @@
+#! /usr/bin/env python3
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+
+# Parallel, resumable parameter sweep for wifi_jows_2_new.
+#
+# Every key=values argument is one axis of the grid (values separated by commas, integer ranges as
+# first:last); all other --name=value options of wifi_jows_2_new are passed unchanged to every run:
+#
+#   ./wifi_jows_sweep.py -j 8 nSTA=5,10,20,40 Mbps=1,5 RTSCTS=0,1 BE=0,1 BK=0,1 seed=1:10 --simTime=10
+#
+# Runs are taken from one shared queue by -j workers, most expensive first (estimated from nSTA, the
+# number of enabled ACs, Mbps and simTime), so long runs do not end up last on one worker. Every
+# finished run is appended to the checkpoint file (JSON lines); a sweep started again with the same
+# checkpoint skips the points already done. The per-TID results of all points are written to one
+# CSV table (also rebuilt from the checkpoint alone with --table-only). With --cache, points already
+# computed by any earlier sweep with the same binary are taken from the result store (wifi_jows_cache.py).
+
+import argparse
+import concurrent.futures
+import itertools
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+import threading
+import time
+
+from wifi_jows_cache import ResultCache
+
+DEFAULT_COMMAND = './waf --run-no-build "wifi_jows_2_new {args}"'
+
+# defaults of wifi_jows_2_new (used for the cost estimate when a key is not swept)
+DEFAULTS = {'nSTA': 3, 'Mbps': 10.0, 'simTime': 10.0,
+            'A_VO': 1, 'VO': 1, 'VI': 1, 'A_VI': 1, 'BE': 1, 'BK': 1}
+
+AC_FLAGS = ('A_VO', 'VO', 'VI', 'A_VI', 'BE', 'BK')
+TID_NAMES = {'7': 'A_VO', '6': 'VO', '5': 'VI', '4': 'A_VI', '0': 'BE', '1': 'BK', 'Total': 'Total'}
+METRICS = ('Tx packets', 'Rx packets', 'Lost packets', 'Throughput', 'Mean delay', 'Delay p50', 'Delay p99',
+           'Delay p99.9', 'Mean jitter')
+
+BLOCK = re.compile(r'^=+(?:TID: (\d+)|(Total))')
+LINE = re.compile(r'^\s+([A-Za-z][A-Za-z ()0-9.-]*):\t(\S+)')
+
+
+def expand(value):
+    values = []
+    for v in value.split(','):
+        m = re.match(r'^(-?\d+):(-?\d+)$', v)
+        if m:
+            values += [str(i) for i in range(int(m.group(1)), int(m.group(2)) + 1)]
+        else:
+            values.append(v)
+    return values
+
+
+def grid_points(axes):
+    names = sorted(axes)
+    for combination in itertools.product(*(axes[n] for n in names)):
+        yield dict(zip(names, combination))
+
+
+def canonical(point, fixed):
+    return ' '.join('--%s=%s' % (k, v) for k, v in sorted(list(fixed.items()) + list(point.items())))
+
+
+def expected_cost(point, fixed):
+    def get(key):
+        return float(point.get(key, fixed.get(key, DEFAULTS.get(key, 0))))
+
+    acs = sum(1 for f in AC_FLAGS if get(f) != 0)
+    # events grow with the number of contending queues and the offered load (bounded by the 54 Mb/s PHY)
+    return get('nSTA') * max(acs, 1) * min(get('Mbps') * max(acs, 1), 54.0) * get('simTime')
+
+
+def parse_output(text):
+    results = {}
+    block = None
+    for line in text.splitlines():
+        if line.startswith('='):  # other blocks (Performance, Queues, ...) are not tabulated
+            m = BLOCK.match(line)
+            block = TID_NAMES.get(m.group(1) or m.group(2)) if m else None
+            continue
+        m = LINE.match(line)
+        if block and m:
+            value = m.group(2)
+            results['%s %s' % (block, m.group(1))] = '' if value.startswith('---') else value
+    return results
+
+
+def run_point(command, args, cache=None, binary=None):
+    if cache is not None:
+        start = time.time()
+        stdout, hit = cache.run('wifi_jows_2_new', args.split(), binary, command)
+        return parse_output(stdout), time.time() - start, hit
+
+    cmd = shlex.split(command.format(args=args))
+    start = time.time()
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if proc.returncode != 0:
+        raise RuntimeError('exit code %d: %s' % (proc.returncode, proc.stderr.strip().splitlines()[-1:]))
+    return parse_output(proc.stdout), time.time() - start, False
+
+
+def load_checkpoint(path):
+    done = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                line = line.strip()
+                if not line:
+                    continue
+                try:
+                    entry = json.loads(line)
+                except ValueError:  # last line of an interrupted write
+                    continue
+                done[entry['key']] = entry
+    return done
+
+
+def write_table(path, entries):
+    params = sorted({k for e in entries for k in e['params']})
+    columns = []
+    for block in list(TID_NAMES.values()):
+        for metric in METRICS:
+            columns.append('%s %s' % (block, metric))
+    extra = sorted({k for e in entries for k in e['results']} - set(columns))
+
+    with open(path, 'w') as f:
+        f.write(','.join(params + columns + extra + ['wallSeconds']) + '\n')
+        for e in sorted(entries, key=lambda e: e['key']):
+            row = [str(e['params'].get(p, '')) for p in params]
+            row += [e['results'].get(c, '') for c in columns + extra]
+            row.append('%.2f' % e['wall'])
+            f.write(','.join(row) + '\n')
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Parallel resumable parameter sweep for wifi_jows_2_new.')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count() or 1, help='parallel runs')
+    parser.add_argument('--command', default=DEFAULT_COMMAND,
+                        help='command running one point, {args} is replaced by the options (default: %(default)s)')
+    parser.add_argument('--checkpoint', default='sweep.jsonl', help='completed points (default: %(default)s)')
+    parser.add_argument('--output', default='sweep.csv', help='consolidated table (default: %(default)s)')
+    parser.add_argument('--cache', help='result store directory shared between sweeps (default: no store)')
+    parser.add_argument('--binary', help='built wifi_jows_2_new, for the build ID of the store keys '
+                                         '(default: newest match under build/)')
+    parser.add_argument('--table-only', action='store_true', help='only rebuild the table from the checkpoint')
+    parser.add_argument('--dry-run', action='store_true', help='only list the points still to run')
+    options, rest = parser.parse_known_args(argv[1:])
+
+    axes, fixed = {}, {}
+    for arg in rest:
+        m = re.match(r'^(--)?([A-Za-z_][A-Za-z0-9_/]*)=(.*)$', arg)
+        if not m:
+            parser.error('unexpected argument %s' % arg)
+        if m.group(1):
+            fixed[m.group(2)] = m.group(3)
+        else:
+            axes[m.group(2)] = expand(m.group(3))
+
+    done = load_checkpoint(options.checkpoint)
+    if options.table_only:
+        write_table(options.output, list(done.values()))
+        return
+
+    points = []
+    for point in grid_points(axes):
+        key = canonical(point, fixed)
+        if key not in done:
+            points.append((expected_cost(point, fixed), key, dict(fixed, **point)))
+    points.sort(key=lambda p: p[0], reverse=True)  # longest expected first
+
+    total = len(points) + len(done)
+    print('%d points, %d done, %d to run on %d workers' % (total, len(done), len(points), options.jobs))
+    if options.dry_run:
+        for cost, key, _ in points:
+            print('%12.0f  %s' % (cost, key))
+        return
+
+    lock = threading.Lock()
+    failed = []
+    cache = ResultCache(options.cache) if options.cache else None
+
+    def work(key, params):
+        try:
+            results, wall, hit = run_point(options.command, key, cache, options.binary)
+        except (RuntimeError, OSError) as e:
+            with lock:
+                failed.append(key)
+                print('FAILED %s (%s)' % (key, e), file=sys.stderr)
+            return
+        entry = {'key': key, 'params': params, 'results': results, 'wall': wall}
+        with lock:
+            with open(options.checkpoint, 'a') as f:
+                f.write(json.dumps(entry, sort_keys=True) + '\n')
+                f.flush()
+                os.fsync(f.fileno())
+            done[key] = entry
+            print('[%d/%d] %s  %s' % (len(done), total, 'cached' if hit else '%.1f s' % wall, key))
+
+    # the executor hands the next queued point to whichever worker becomes free
+    with concurrent.futures.ThreadPoolExecutor(max_workers=options.jobs) as pool:
+        try:
+            for future in [pool.submit(work, key, params) for _, key, params in points]:
+                future.result()
+        except KeyboardInterrupt:
+            pool.shutdown(wait=False, cancel_futures=True)
+            print('interrupted - completed points are kept in %s' % options.checkpoint, file=sys.stderr)
+            raise
+
+    write_table(options.output, list(done.values()))
+    print('%d points written to %s%s' % (len(done), options.output,
+                                         (', %d failed' % len(failed)) if failed else ''))
+    if failed:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -9,6 +9,7 @@
 # See test.py for more information.
 cpp_examples = [
     ("mixed-wired-wireless", "True", "True"),
+    ("mixed-wired-wireless --p2pBackbone=1 --tracing=0", "True", "True"),
     ("wifi-multirate --totalTime=0.3s --rateManager=ns3::AarfcdWifiManager", "True", "True"),
     ("wifi-multirate --totalTime=0.3s --rateManager=ns3::AmrrWifiManager", "True", "False"),
     ("wifi-multirate --totalTime=0.3s --rateManager=ns3::CaraWifiManager", "True", "False"),
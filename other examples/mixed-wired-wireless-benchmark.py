@@ -0,0 +1,133 @@
+#! /usr/bin/env python3
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+
+# Speed-up of distributed mixed-wired-wireless runs (--distributed=1 under mpirun) over the sequential
+# run of the same point-to-point backbone topology (--p2pBackbone=1), on one machine:
+#
+#   ./mixed-wired-wireless-benchmark.py --backboneNodes=300 --ranks=2,4,8
+#   ./mixed-wired-wireless-benchmark.py --ranks=4 --nullMessage --mpirun="mpirun --oversubscribe -np {ranks}"
+#
+# Every run prints the Flow and Performance blocks on rank 0; the wall time is that of the slowest rank.
+# The received packets of every run must match the sequential run (within 1% - the random streams of
+# the wifi clusters are assigned per rank), otherwise the partitioning changed the results and the run
+# is flagged (exit code 1).
+
+import argparse
+import json
+import re
+import shlex
+import subprocess
+import sys
+import time
+
+SEQUENTIAL = './waf --run-no-build "mixed-wired-wireless {args}"'
+DISTRIBUTED = './waf --run-no-build mixed-wired-wireless --command-template="{mpirun} %s {args}"'
+
+LINE = re.compile(r'^\s+([A-Za-z/ ]+):\t([0-9.eE+-]+)')
+VALUES = {
+    'Rx packets': 'rxPackets',
+    'Tx packets': 'txPackets',
+    'Wall time': 'wallSeconds',
+    'Events': 'events',
+    'Events/s': 'eventsPerSecond',
+    'Peak RSS': 'peakRssKb',
+}
+
+
+def parse(text):
+    values = {}
+    for line in text.splitlines():
+        m = LINE.match(line)
+        if m and m.group(1) in VALUES:
+            values[VALUES[m.group(1)]] = float(m.group(2))
+    return values
+
+
+def run(command):
+    start = time.time()
+    proc = subprocess.Popen(shlex.split(command), stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    stdout, stderr = proc.communicate()
+    if proc.returncode != 0:
+        raise RuntimeError('exit code %d: %s' % (proc.returncode, stderr.strip().splitlines()[-1:]))
+    values = parse(stdout)
+    if 'wallSeconds' not in values:
+        raise RuntimeError('no Performance block in the output')
+    values['processWallSeconds'] = time.time() - start  # incl. setup, MPI start-up and the waf wrapper
+    return values
+
+
+def best_of(command, repeat):
+    best = None
+    for _ in range(repeat):
+        values = run(command)
+        if best is None or values['wallSeconds'] < best['wallSeconds']:
+            best = values
+    return best
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Distributed vs. sequential mixed-wired-wireless.')
+    parser.add_argument('--backboneNodes', type=int, default=200)
+    parser.add_argument('--infraNodes', type=int, default=2)
+    parser.add_argument('--lanNodes', type=int, default=2)
+    parser.add_argument('--stopTime', type=int, default=20)
+    parser.add_argument('--backboneDelay', type=float, default=2, help='lookahead [ms] (default: %(default)s)')
+    parser.add_argument('--ranks', default='2,4', help='comma-separated rank counts (default: %(default)s)')
+    parser.add_argument('--nullMessage', action='store_true', help='null message synchronization')
+    parser.add_argument('--mpirun', default='mpirun -np {ranks}', help='MPI launcher (default: %(default)s)')
+    parser.add_argument('--repeat', type=int, default=1, help='runs per point, the fastest one is kept')
+    parser.add_argument('--output', help='JSON file of the results')
+    options = parser.parse_args(argv[1:])
+
+    args = '--backboneNodes=%d --infraNodes=%d --lanNodes=%d --stopTime=%d --backboneDelay=%g --tracing=0 --perfReport=1' % (
+        options.backboneNodes, options.infraNodes, options.lanNodes, options.stopTime, options.backboneDelay)
+
+    results = []
+    try:
+        sequential = best_of(SEQUENTIAL.format(args=args + ' --p2pBackbone=1'), options.repeat)
+    except (RuntimeError, OSError) as e:
+        sys.exit('sequential run failed (%s)' % e)
+    sequential['ranks'] = 1
+    results.append(sequential)
+
+    distributed_args = args + ' --distributed=1' + (' --nullMessage=1' if options.nullMessage else '')
+    failed = []
+    for ranks in [int(r) for r in options.ranks.split(',') if r]:
+        command = DISTRIBUTED.format(mpirun=options.mpirun.format(ranks=ranks), args=distributed_args)
+        try:
+            values = best_of(command, options.repeat)
+        except (RuntimeError, OSError) as e:
+            print('FAILED %d ranks (%s)' % (ranks, e), file=sys.stderr)
+            failed.append(ranks)
+            continue
+        values['ranks'] = ranks
+        results.append(values)
+
+    print('%d backbone nodes, %g s simulated, %s synchronization' % (
+        options.backboneNodes, options.stopTime, 'null message' if options.nullMessage else 'granted time window'))
+    print('%6s %10s %9s %11s %12s %10s' % ('ranks', 'wall [s]', 'speed-up', 'efficiency', 'events/s', 'rx pkts'))
+    mismatch = []
+    for r in results:
+        speedup = sequential['wallSeconds'] / r['wallSeconds'] if r['wallSeconds'] > 0 else 0
+        r['speedup'] = speedup
+        print('%6d %10.3f %9.2f %10.0f%% %12.0f %10d' % (
+            r['ranks'], r['wallSeconds'], speedup, 100 * speedup / r['ranks'], r.get('eventsPerSecond', 0),
+            r.get('rxPackets', 0)))
+        if abs(r.get('rxPackets', 0) - sequential.get('rxPackets', 0)) > max(1, 0.01 * sequential.get('rxPackets', 0)):
+            mismatch.append(r['ranks'])
+    for ranks in mismatch:
+        print('MISMATCH %d ranks: received packets differ from the sequential run by more than 1%%' % ranks)
+
+    if options.output:
+        with open(options.output, 'w') as f:
+            json.dump({'args': args, 'nullMessage': options.nullMessage, 'results': results}, f, indent=2,
+                      sort_keys=True)
+            f.write('\n')
+
+    if failed or mismatch:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -57,6 +57,19 @@
 //
 // Note that certain mobility patterns may cause packet forwarding
 // to fail (if nodes become disconnected)
+//
+// With --p2pBackbone=1 the backbone routers are connected in a ring of
+// point-to-point links (static shortest-path routes instead of OLSR).
+// This topology can be partitioned: with --distributed=1 (ns-3 built
+// with --enable-mpi) every backbone router and its LAN and infrastructure
+// cluster is assigned to one MPI rank (contiguous blocks of clusters),
+// the ring links crossing ranks give the lookahead (--backboneDelay).
+// The statistics of the flow are gathered on rank 0:
+//
+//   ./waf --run "mixed-wired-wireless --p2pBackbone=1 --tracing=0 --perfReport=1"
+//   ./waf --run mixed-wired-wireless --command-template="mpirun -np 4 %s --distributed=1 --perfReport=1"
+//
+// mixed-wired-wireless-benchmark.py compares both for growing rank counts.
 
 #include "ns3/command-line.h"
 #include "ns3/string.h"
@@ -72,6 +85,15 @@
 #include "ns3/olsr-helper.h"
 #include "ns3/csma-helper.h"
 #include "ns3/animation-interface.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/global-value.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#endif
+#include "perf-report.h"
 
 using namespace ns3;
 
@@ -91,6 +113,54 @@ CourseChangeCallback (std::string path, Ptr<const MobilityModel> model)
   std::cout << "CourseChange " << path << " x=" << position.x << ", y=" << position.y << ", z=" << position.z << std::endl;
 }
 
+//
+// Counters of the example flow and of the run, summed over all ranks
+// (distributed=1) and printed by rank 0
+//
+struct RunCounters
+{
+  uint64_t txPackets;
+  uint64_t rxPackets;
+  uint64_t rxBytes;
+  uint64_t events;
+};
+
+static RunCounters g_counters = { 0, 0, 0, 0 };
+
+static void
+SourceTx (Ptr<const Packet> packet)
+{
+  g_counters.txPackets++;
+}
+
+static void
+SinkRx (Ptr<const Packet> packet, const Address &from)
+{
+  g_counters.rxPackets++;
+  g_counters.rxBytes += packet->GetSize ();
+}
+
+//
+// Rank owning backbone router i and its LAN and infrastructure cluster -
+// contiguous blocks, so only the two ring links at the block borders
+// cross ranks
+//
+static uint32_t
+ClusterRank (uint32_t i, uint32_t backboneNodes, uint32_t ranks)
+{
+  return (uint64_t) i * ranks / backboneNodes;
+}
+
+//
+// Network of cluster i in an address space handed out by one
+// Ipv4AddressHelper /24 network per cluster (as NewNetwork () does)
+//
+static Ipv4Address
+ClusterNetwork (const char *base, uint32_t i)
+{
+  return Ipv4Address (Ipv4Address (base).Get () + (i << 8));
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -103,6 +173,12 @@ main (int argc, char *argv[])
   uint32_t lanNodes = 2;
   uint32_t stopTime = 20;
   bool useCourseChangeCallback = false;
+  bool p2pBackbone = false;
+  bool distributed = false;
+  bool nullMessage = false;
+  double backboneDelay = 2;
+  bool tracing = true;
+  bool perfReport = false;
 
   //
   // Simulation defaults are typically set next, before command line
@@ -122,6 +198,12 @@ main (int argc, char *argv[])
   cmd.AddValue ("lanNodes", "number of LAN nodes", lanNodes);
   cmd.AddValue ("stopTime", "simulation stop time (seconds)", stopTime);
   cmd.AddValue ("useCourseChangeCallback", "whether to enable course change tracing", useCourseChangeCallback);
+  cmd.AddValue ("p2pBackbone", "ring of point-to-point links instead of the ad hoc wifi backbone", p2pBackbone);
+  cmd.AddValue ("distributed", "one cluster block per MPI rank (implies p2pBackbone, needs mpirun)", distributed);
+  cmd.AddValue ("nullMessage", "null message instead of granted time window synchronization (distributed)", nullMessage);
+  cmd.AddValue ("backboneDelay", "delay of the point-to-point backbone links [ms] (lookahead of distributed runs)", backboneDelay);
+  cmd.AddValue ("tracing", "write the ascii, pcap and animation traces", tracing);
+  cmd.AddValue ("perfReport", "print wall time, events/s and peak RSS (over all ranks)", perfReport);
 
   //
   // The system global variables and the local values added to the argument
@@ -134,6 +216,31 @@ main (int argc, char *argv[])
       std::cout << "Use a simulation stop time >= 10 seconds" << std::endl;
       exit (1);
     }
+
+  uint32_t rank = 0;
+  uint32_t ranks = 1;
+  if (distributed)
+    {
+#ifdef NS3_MPI
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue (nullMessage ? "ns3::NullMessageSimulatorImpl" : "ns3::DistributedSimulatorImpl"));
+      MpiInterface::Enable (&argc, &argv);
+      rank = MpiInterface::GetSystemId ();
+      ranks = MpiInterface::GetSize ();
+#else
+      std::cout << "distributed=1 needs ns-3 configured with --enable-mpi" << std::endl;
+      exit (1);
+#endif
+      if (ranks > backboneNodes)
+        {
+          std::cout << "Use at most one rank per backbone node" << std::endl;
+          exit (1);
+        }
+      // Only point-to-point links can cross ranks; the traces of all
+      // ranks would end up in the same files
+      p2pBackbone = true;
+      tracing = false;
+    }
   ///////////////////////////////////////////////////////////////////////////
   //                                                                       //
   // Construct the backbone                                                //
@@ -144,8 +251,14 @@ main (int argc, char *argv[])
   // Create a container to manage the nodes of the adhoc (backbone) network.
   // Later we'll create the rest of the nodes we'll need.
   //
+  // Every rank creates all nodes (same node IDs everywhere), each one
+  // with the rank owning its cluster as system ID
+  //
   NodeContainer backbone;
-  backbone.Create (backboneNodes);
+  for (uint32_t i = 0; i < backboneNodes; ++i)
+    {
+      backbone.Create (1, ClusterRank (i, backboneNodes, ranks));
+    }
   //
   // Create the backbone wifi net devices and install them into the nodes in
   // our container
@@ -157,18 +270,41 @@ main (int argc, char *argv[])
                                 "DataMode", StringValue ("OfdmRate54Mbps"));
   YansWifiPhyHelper wifiPhy;
   YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
-  wifiPhy.SetChannel (wifiChannel.Create ());
-  NetDeviceContainer backboneDevices = wifi.Install (wifiPhy, mac, backbone);
+  NetDeviceContainer backboneDevices;
+  PointToPointHelper p2p;
+  std::vector<Ipv4InterfaceContainer> ringInterfaces;
+  uint32_t ringLinks = (backboneNodes > 2) ? backboneNodes : backboneNodes - 1;
+  if (!p2pBackbone)
+    {
+      wifiPhy.SetChannel (wifiChannel.Create ());
+      backboneDevices = wifi.Install (wifiPhy, mac, backbone);
+    }
+  else
+    {
+      // Link i connects backbone routers i and i+1 (ring); links between
+      // routers of different ranks become remote channels
+      p2p.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+      p2p.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (backboneDelay)));
+      for (uint32_t i = 0; i < ringLinks; ++i)
+        {
+          backboneDevices.Add (p2p.Install (backbone.Get (i), backbone.Get ((i + 1) % backboneNodes)));
+        }
+    }
 
   // We enable OLSR (which will be consulted at a higher priority than
   // the global routing) on the backbone ad hoc nodes
+  // (dynamic routing is not supported by the distributed simulator - the
+  // point-to-point backbone gets static routes below)
   NS_LOG_INFO ("Enabling OLSR routing on all backbone nodes");
   OlsrHelper olsr;
   //
   // Add the IPv4 protocol stack to the nodes in our container
   //
   InternetStackHelper internet;
-  internet.SetRoutingHelper (olsr); // has effect on the next Install ()
+  if (!p2pBackbone)
+    {
+      internet.SetRoutingHelper (olsr); // has effect on the next Install ()
+    }
   internet.Install (backbone);
 
   //
@@ -176,8 +312,21 @@ main (int argc, char *argv[])
   // IPv4 interfaces) we just created.
   //
   Ipv4AddressHelper ipAddrs;
-  ipAddrs.SetBase ("192.168.0.0", "255.255.255.0");
-  ipAddrs.Assign (backboneDevices);
+  if (!p2pBackbone)
+    {
+      ipAddrs.SetBase ("192.168.0.0", "255.255.255.0");
+      ipAddrs.Assign (backboneDevices);
+    }
+  else
+    {
+      ipAddrs.SetBase ("192.168.0.0", "255.255.255.252");
+      for (uint32_t i = 0; i < ringLinks; ++i)
+        {
+          NetDeviceContainer link (backboneDevices.Get (2 * i), backboneDevices.Get (2 * i + 1));
+          ringInterfaces.push_back (ipAddrs.Assign (link));
+          ipAddrs.NewNetwork ();
+        }
+    }
 
   //
   // The ad-hoc network nodes need a mobility model so we aggregate one to
@@ -191,10 +340,18 @@ main (int argc, char *argv[])
                                  "DeltaY", DoubleValue (20.0),
                                  "GridWidth", UintegerValue (5),
                                  "LayoutType", StringValue ("RowFirst"));
-  mobility.SetMobilityModel ("ns3::RandomDirection2dMobilityModel",
-                             "Bounds", RectangleValue (Rectangle (-500, 500, -500, 500)),
-                             "Speed", StringValue ("ns3::ConstantRandomVariable[Constant=2]"),
-                             "Pause", StringValue ("ns3::ConstantRandomVariable[Constant=0.2]"));
+  if (!p2pBackbone)
+    {
+      mobility.SetMobilityModel ("ns3::RandomDirection2dMobilityModel",
+                                 "Bounds", RectangleValue (Rectangle (-500, 500, -500, 500)),
+                                 "Speed", StringValue ("ns3::ConstantRandomVariable[Constant=2]"),
+                                 "Pause", StringValue ("ns3::ConstantRandomVariable[Constant=0.2]"));
+    }
+  else
+    {
+      // Positions of wired routers do not matter - no mobility events
+      mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+    }
   mobility.Install (backbone);
 
   ///////////////////////////////////////////////////////////////////////////
@@ -217,7 +374,14 @@ main (int argc, char *argv[])
       // with all of the nodes including new and existing nodes
       //
       NodeContainer newLanNodes;
-      newLanNodes.Create (lanNodes - 1);
+      newLanNodes.Create (lanNodes - 1, ClusterRank (i, backboneNodes, ranks));
+      if (ClusterRank (i, backboneNodes, ranks) != rank)
+        {
+          // Cluster simulated by another rank - only its nodes (for the
+          // node IDs) and its network number are needed here
+          ipAddrs.NewNetwork ();
+          continue;
+        }
       // Now, create the container with all nodes on this link
       NodeContainer lan (backbone.Get (i), newLanNodes);
       //
@@ -237,7 +401,17 @@ main (int argc, char *argv[])
       // Assign IPv4 addresses to the device drivers (actually to the
       // associated IPv4 interfaces) we just created.
       //
-      ipAddrs.Assign (lanDevices);
+      Ipv4InterfaceContainer lanInterfaces = ipAddrs.Assign (lanDevices);
+      if (p2pBackbone)
+        {
+          // LAN hosts reach everything through their backbone router
+          Ipv4StaticRoutingHelper staticRouting;
+          for (uint32_t j = 0; j < newLanNodes.GetN (); ++j)
+            {
+              Ptr<Ipv4> ipv4 = newLanNodes.Get (j)->GetObject<Ipv4> ();
+              staticRouting.GetStaticRouting (ipv4)->SetDefaultRoute (lanInterfaces.GetAddress (0), 1);
+            }
+        }
       //
       // Assign a new network prefix for the next LAN, according to the
       // network mask initialized above
@@ -279,7 +453,12 @@ main (int argc, char *argv[])
       // with all of the nodes including new and existing nodes
       //
       NodeContainer stas;
-      stas.Create (infraNodes - 1);
+      stas.Create (infraNodes - 1, ClusterRank (i, backboneNodes, ranks));
+      if (ClusterRank (i, backboneNodes, ranks) != rank)
+        {
+          ipAddrs.NewNetwork ();
+          continue;
+        }
       // Now, create the container with all nodes on this link
       NodeContainer infra (backbone.Get (i), stas);
       //
@@ -313,7 +492,17 @@ main (int argc, char *argv[])
       // Assign IPv4 addresses to the device drivers (actually to the associated
       // IPv4 interfaces) we just created.
       //
-      ipAddrs.Assign (infraDevices);
+      Ipv4InterfaceContainer infraInterfaces = ipAddrs.Assign (infraDevices);
+      if (p2pBackbone)
+        {
+          // Stations reach everything through their access point
+          Ipv4StaticRoutingHelper staticRouting;
+          for (uint32_t j = 0; j < stas.GetN (); ++j)
+            {
+              Ptr<Ipv4> ipv4 = stas.Get (j)->GetObject<Ipv4> ();
+              staticRouting.GetStaticRouting (ipv4)->SetDefaultRoute (infraInterfaces.GetAddress (0), 1);
+            }
+        }
       //
       // Assign a new network prefix for each mobile network, according to
       // the network mask initialized above
@@ -338,6 +527,53 @@ main (int argc, char *argv[])
       mobility.Install (stas);
     }
 
+  ///////////////////////////////////////////////////////////////////////////
+  //                                                                       //
+  // Backbone routes (p2pBackbone)                                         //
+  //                                                                       //
+  ///////////////////////////////////////////////////////////////////////////
+
+  // Every router sends the traffic of another cluster the shorter way
+  // around the ring; clusters are 172.16.i.0/24 (LAN) and 10.0.i.0/24
+  // (infrastructure network)
+  if (p2pBackbone)
+    {
+      Ipv4StaticRoutingHelper staticRouting;
+      for (uint32_t i = 0; i < backboneNodes; ++i)
+        {
+          if (ClusterRank (i, backboneNodes, ranks) != rank)
+            {
+              continue;
+            }
+          Ptr<Ipv4> ipv4 = backbone.Get (i)->GetObject<Ipv4> ();
+          Ptr<Ipv4StaticRouting> routing = staticRouting.GetStaticRouting (ipv4);
+          for (uint32_t j = 0; j < backboneNodes; ++j)
+            {
+              if (j == i)
+                {
+                  continue;
+                }
+              uint32_t forward = (j + backboneNodes - i) % backboneNodes;
+              uint32_t link;
+              uint32_t peer; // end of the link at the neighbour
+              if (forward <= backboneNodes / 2 && i < ringLinks)
+                {
+                  link = i;     // towards router i+1
+                  peer = 1;
+                }
+              else
+                {
+                  link = (i + backboneNodes - 1) % backboneNodes; // towards router i-1
+                  peer = 0;
+                }
+              Ipv4Address nextHop = ringInterfaces[link].GetAddress (peer);
+              uint32_t interface = ipv4->GetInterfaceForDevice (backboneDevices.Get (2 * link + 1 - peer));
+              routing->AddNetworkRouteTo (ClusterNetwork ("172.16.0.0", j), Ipv4Mask ("255.255.255.0"), nextHop, interface);
+              routing->AddNetworkRouteTo (ClusterNetwork ("10.0.0.0", j), Ipv4Mask ("255.255.255.0"), nextHop, interface);
+            }
+        }
+    }
+
   ///////////////////////////////////////////////////////////////////////////
   //                                                                       //
   // Application configuration                                             //
@@ -363,20 +599,35 @@ main (int argc, char *argv[])
   uint32_t lastNodeIndex = backboneNodes + backboneNodes * (lanNodes - 1) + backboneNodes * (infraNodes - 1) - 1;
   Ptr<Node> appSink = NodeList::GetNode (lastNodeIndex);
   // Let's fetch the IP address of the last node, which is on Ipv4Interface 1
-  Ipv4Address remoteAddr = appSink->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+  // (the sink may be simulated by another rank - its address is computed then)
+  Ipv4Address remoteAddr = ClusterNetwork ("10.0.0.0", backboneNodes - 1);
+  remoteAddr.Set (remoteAddr.Get () + infraNodes);
+  if (appSink->GetObject<Ipv4> () != 0)
+    {
+      remoteAddr = appSink->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+    }
 
-  OnOffHelper onoff ("ns3::UdpSocketFactory",
-                     Address (InetSocketAddress (remoteAddr, port)));
+  // Applications only run on the rank owning their node
+  if (appSource->GetSystemId () == rank)
+    {
+      OnOffHelper onoff ("ns3::UdpSocketFactory",
+                         Address (InetSocketAddress (remoteAddr, port)));
 
-  ApplicationContainer apps = onoff.Install (appSource);
-  apps.Start (Seconds (3));
-  apps.Stop (Seconds (stopTime - 1));
+      ApplicationContainer apps = onoff.Install (appSource);
+      apps.Start (Seconds (3));
+      apps.Stop (Seconds (stopTime - 1));
+      apps.Get (0)->TraceConnectWithoutContext ("Tx", MakeCallback (&SourceTx));
+    }
 
-  // Create a packet sink to receive these packets
-  PacketSinkHelper sink ("ns3::UdpSocketFactory",
-                         InetSocketAddress (Ipv4Address::GetAny (), port));
-  apps = sink.Install (appSink);
-  apps.Start (Seconds (3));
+  if (appSink->GetSystemId () == rank)
+    {
+      // Create a packet sink to receive these packets
+      PacketSinkHelper sink ("ns3::UdpSocketFactory",
+                             InetSocketAddress (Ipv4Address::GetAny (), port));
+      ApplicationContainer apps = sink.Install (appSink);
+      apps.Start (Seconds (3));
+      apps.Get (0)->TraceConnectWithoutContext ("Rx", MakeCallback (&SinkRx));
+    }
 
   ///////////////////////////////////////////////////////////////////////////
   //                                                                       //
@@ -386,30 +637,41 @@ main (int argc, char *argv[])
 
   NS_LOG_INFO ("Configure Tracing.");
   CsmaHelper csma;
+  AnimationInterface *anim = 0;
 
-  //
-  // Let's set up some ns-2-like ascii traces, using another helper class
-  //
-  AsciiTraceHelper ascii;
-  Ptr<OutputStreamWrapper> stream = ascii.CreateFileStream ("mixed-wireless.tr");
-  wifiPhy.EnableAsciiAll (stream);
-  csma.EnableAsciiAll (stream);
-  internet.EnableAsciiIpv4All (stream);
-
-  // Csma captures in non-promiscuous mode
-  csma.EnablePcapAll ("mixed-wireless", false);
-  // pcap captures on the backbone wifi devices
-  wifiPhy.EnablePcap ("mixed-wireless", backboneDevices, false);
-  // pcap trace on the application data sink
-  wifiPhy.EnablePcap ("mixed-wireless", appSink->GetId (), 0);
+  if (tracing)
+    {
+      //
+      // Let's set up some ns-2-like ascii traces, using another helper class
+      //
+      AsciiTraceHelper ascii;
+      Ptr<OutputStreamWrapper> stream = ascii.CreateFileStream ("mixed-wireless.tr");
+      wifiPhy.EnableAsciiAll (stream);
+      csma.EnableAsciiAll (stream);
+      internet.EnableAsciiIpv4All (stream);
+
+      // Csma captures in non-promiscuous mode
+      csma.EnablePcapAll ("mixed-wireless", false);
+      // pcap captures on the backbone wifi (or point-to-point) devices
+      if (!p2pBackbone)
+        {
+          wifiPhy.EnablePcap ("mixed-wireless", backboneDevices, false);
+        }
+      else
+        {
+          p2p.EnablePcap ("mixed-wireless", backboneDevices, false);
+        }
+      // pcap trace on the application data sink
+      wifiPhy.EnablePcap ("mixed-wireless", appSink->GetId (), 0);
+
+      anim = new AnimationInterface ("mixed-wireless.xml");
+    }
 
   if (useCourseChangeCallback == true)
     {
       Config::Connect ("/NodeList/*/$ns3::MobilityModel/CourseChange", MakeCallback (&CourseChangeCallback));
     }
 
-  AnimationInterface anim ("mixed-wireless.xml");
-
   ///////////////////////////////////////////////////////////////////////////
   //                                                                       //
   // Run simulation                                                        //
@@ -418,6 +680,44 @@ main (int argc, char *argv[])
 
   NS_LOG_INFO ("Run Simulation.");
   Simulator::Stop (Seconds (stopTime));
-  Simulator::Run ();
+  RunMeasured ();
+  g_counters.events = g_perf.events;
+  PerfCounters perf = g_perf;
+  long peakRss = PeakRss ();
+
+#ifdef NS3_MPI
+  if (distributed)
+    {
+      // Sums of the counters, the slowest rank and the largest one
+      RunCounters local = g_counters;
+      long localRss = peakRss;
+      MPI_Reduce (&local, &g_counters, 4, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+      MPI_Reduce (&g_perf.wallSeconds, &perf.wallSeconds, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+      MPI_Reduce (&localRss, &peakRss, 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+      perf.events = g_counters.events;
+    }
+#endif
+
+  if (rank == 0)
+    {
+      std::cout << "=======================Flow: ===================================" << std::endl;
+      std::cout << "  Tx packets:\t"   << g_counters.txPackets << std::endl;
+      std::cout << "  Rx packets:\t"   << g_counters.rxPackets << std::endl;
+      std::cout << "  Rx bytes:\t"     << g_counters.rxBytes << std::endl;
+      std::cout << "  Lost packets:\t" << g_counters.txPackets - g_counters.rxPackets << std::endl;
+      if (perfReport)
+        {
+          // Wall time of the slowest rank, events of all ranks
+          PrintPerfReport (perf, peakRss, ranks);
+        }
+    }
+
   Simulator::Destroy ();
+  delete anim;
+#ifdef NS3_MPI
+  if (distributed)
+    {
+      MpiInterface::Disable ();
+    }
+#endif
 }
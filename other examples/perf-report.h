@@ -0,0 +1,83 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PERF_REPORT_H
+#define PERF_REPORT_H
+
+#include "ns3/simulator.h"
+#include <chrono>
+#include <iostream>
+#include <sys/resource.h>
+
+// perfReport=1 of the examples: wall time, events and peak RSS of the
+// simulator runs, printed as the "Performance" block of wifi_jows_2_new
+// (read by wifi-benchmark.py). Included by one source file per program,
+// so the counters are per program.
+
+struct PerfCounters
+{
+  double wallSeconds;
+  double simulatedSeconds;
+  uint64_t events;
+};
+
+// Simulator runs of the example, accumulated by RunMeasured
+static PerfCounters g_perf = { 0, 0, 0 };
+
+inline void
+RunMeasured (void)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  ns3::Simulator::Run ();
+  g_perf.wallSeconds += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  g_perf.simulatedSeconds += ns3::Simulator::Now ().GetSeconds ();
+  g_perf.events += ns3::Simulator::GetEventCount ();
+}
+
+// [kB]
+inline long
+PeakRss (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Counters given explicitly - e.g. reduced over the ranks of a distributed
+// run (ranks > 0 is printed first)
+inline void
+PrintPerfReport (const PerfCounters &perf, long peakRss, uint32_t ranks = 0)
+{
+  std::cout << "=======================Performance: ===============================" << std::endl;
+  if (ranks > 0)
+    {
+      std::cout << "  Ranks:\t"         << ranks << std::endl;
+    }
+  std::cout << "  Wall time:\t"       << perf.wallSeconds << " s" << std::endl;
+  std::cout << "  Simulated time:\t"  << perf.simulatedSeconds << " s" << std::endl;
+  std::cout << "  Events:\t"          << perf.events << std::endl;
+  std::cout << "  Events/s:\t"        << (perf.wallSeconds > 0 ? perf.events / perf.wallSeconds : 0) << std::endl;
+  std::cout << "  Wall/sim s:\t"      << (perf.simulatedSeconds > 0 ? perf.wallSeconds / perf.simulatedSeconds : 0) << std::endl;
+  std::cout << "  Peak RSS:\t"        << peakRss << " kB" << std::endl;
+}
+
+inline void
+PrintPerfReport (void)
+{
+  PrintPerfReport (g_perf, PeakRss ());
+}
+
+#endif /* PERF_REPORT_H */
@@ -0,0 +1,163 @@
+#! /usr/bin/env python3
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+
+# Performance benchmark of representative wifi examples (examples-to-run.py only checks that they run).
+# Every config is run with --perfReport=1; the Performance block it prints gives executed events per
+# second, wall time per simulated second and peak RSS:
+#
+#   ./wifi-benchmark.py --output=bench.json                        run all configs, write the results
+#   ./wifi-benchmark.py --output=bench.json --reference=ref.json   ... and flag regressions against ref.json
+#   ./wifi-benchmark.py --only=wifi_jows_2_new --repeat=3          subset of the configs, best of 3 runs
+#
+# A stored baseline is simply the --output file of an earlier run. Exit code 1 if a regression is flagged.
+
+import argparse
+import json
+import platform
+import re
+import shlex
+import subprocess
+import sys
+import time
+
+DEFAULT_COMMAND = './waf --run-no-build "{program} {args}"'
+
+# (name, program, arguments) - fixed, so that results of different builds are comparable
+CONFIGS = [
+    ('jows-sat-10', 'wifi_jows_2_new', '--nSTA=10 --Mbps=20 --simTime=5 --calcStart=1'),
+    ('jows-sat-50', 'wifi_jows_2_new', '--nSTA=50 --Mbps=20 --simTime=3 --calcStart=1'),
+    ('jows-sat-50-fast', 'wifi_jows_2_new', '--nSTA=50 --Mbps=20 --simTime=3 --calcStart=1 --fast=1'),
+    ('jows-sat-200', 'wifi_jows_2_new', '--nSTA=200 --Mbps=20 --simTime=2 --calcStart=1'),
+    ('multirate', 'wifi-multirate', '--totalTime=3'),
+    ('spectrum-saturation', 'wifi-spectrum-saturation-example', '--simulationTime=1 --index=7'),
+    ('spectrum-saturation-yans', 'wifi-spectrum-saturation-example',
+     '--simulationTime=1 --index=7 --wifiType=ns3::YansWifiPhy'),
+    ('mixed-network', 'wifi-mixed-network', '--simulationTime=1'),
+]
+
+# metric, unit, direction of a regression (+1: higher is worse)
+METRICS = [
+    ('eventsPerSecond', 'events/s', -1),
+    ('wallPerSimSecond', 's/s', +1),
+    ('peakRssKb', 'kB', +1),
+]
+
+PERF = {
+    'Wall time': 'wallSeconds',
+    'Simulated time': 'simulatedSeconds',
+    'Events': 'events',
+    'Events/s': 'eventsPerSecond',
+    'Wall/sim s': 'wallPerSimSecond',
+    'Peak RSS': 'peakRssKb',
+}
+LINE = re.compile(r'^\s+([A-Za-z/ ]+):\t([0-9.eE+-]+)')
+
+
+def parse_perf(text):
+    """values of the (last) Performance block"""
+    values = {}
+    in_block = False
+    for line in text.splitlines():
+        if line.startswith('='):
+            in_block = 'Performance' in line
+            continue
+        m = LINE.match(line)
+        if in_block and m and m.group(1) in PERF:
+            values[PERF[m.group(1)]] = float(m.group(2))
+    return values
+
+
+def run_config(command, program, args):
+    cmd = shlex.split(command.format(program=program, args=args + ' --perfReport=1'))
+    start = time.time()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    stdout, stderr = proc.communicate()
+    wall = time.time() - start
+    if proc.returncode != 0:
+        raise RuntimeError('exit code %d: %s' % (proc.returncode, stderr.strip().splitlines()[-1:]))
+
+    values = parse_perf(stdout)
+    if 'events' not in values:
+        raise RuntimeError('no Performance block in the output (perfReport not supported?)')
+    values['processWallSeconds'] = wall  # incl. setup and the waf wrapper
+    return values
+
+
+def compare(name, result, reference, threshold):
+    """regression messages of one config"""
+    flagged = []
+    for metric, unit, direction in METRICS:
+        if metric not in result or not reference.get(metric):
+            continue
+        change = (result[metric] - reference[metric]) / reference[metric]
+        if direction * change > threshold:
+            flagged.append('%s %s: %.4g -> %.4g %s (%+.1f%%)' % (
+                name, metric, reference[metric], result[metric], unit, 100 * change))
+    return flagged
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Performance benchmark of wifi examples.')
+    parser.add_argument('--command', default=DEFAULT_COMMAND,
+                        help='command running one config, {program} and {args} are replaced (default: %(default)s)')
+    parser.add_argument('--output', default='wifi-benchmark.json', help='results (default: %(default)s)')
+    parser.add_argument('--reference', help='stored baseline to flag regressions against')
+    parser.add_argument('--threshold', type=float, default=0.10,
+                        help='relative change flagged as regression (default: %(default)s)')
+    parser.add_argument('--repeat', type=int, default=1, help='runs per config, the fastest one is kept')
+    parser.add_argument('--only', action='append', default=[], help='configs or programs to run (repeatable)')
+    parser.add_argument('--list', action='store_true', help='only list the configs')
+    options = parser.parse_args(argv[1:])
+
+    configs = [c for c in CONFIGS if not options.only or c[0] in options.only or c[1] in options.only]
+    if options.list:
+        for name, program, args in configs:
+            print('%-26s %s %s' % (name, program, args))
+        return
+
+    reference = {}
+    if options.reference:
+        with open(options.reference) as f:
+            reference = json.load(f)['results']
+
+    results = {}
+    failed = []
+    for name, program, args in configs:
+        best = None
+        for _ in range(options.repeat):
+            try:
+                values = run_config(options.command, program, args)
+            except (RuntimeError, OSError) as e:
+                print('FAILED %s (%s)' % (name, e), file=sys.stderr)
+                failed.append(name)
+                break
+            if best is None or values['wallSeconds'] < best['wallSeconds']:
+                best = values
+        if best is None:
+            continue
+        best.update({'program': program, 'args': args})
+        results[name] = best
+        print('%-26s %12.0f events/s %10.4f s/s %10d kB' % (
+            name, best.get('eventsPerSecond', 0), best.get('wallPerSimSecond', 0), best.get('peakRssKb', 0)))
+
+    with open(options.output, 'w') as f:
+        json.dump({'host': platform.node(), 'machine': platform.machine(), 'time': time.strftime('%Y-%m-%d %H:%M:%S'),
+                   'repeat': options.repeat, 'results': results}, f, indent=2, sort_keys=True)
+        f.write('\n')
+    print('%d configs written to %s' % (len(results), options.output))
+
+    regressions = []
+    for name in sorted(results):
+        if name in reference:
+            regressions += compare(name, results[name], reference[name], options.threshold)
+    for r in regressions:
+        print('REGRESSION %s' % r)
+    if options.reference and not regressions:
+        print('no regressions against %s (threshold %g%%)' % (options.reference, 100 * options.threshold))
+
+    if regressions or failed:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -37,6 +37,7 @@
 #include "ns3/packet-sink-helper.h"
 #include "ns3/packet-sink.h"
 #include "ns3/ht-configuration.h"
+#include "perf-report.h"
 
 // This example shows how to configure mixed networks (i.e. mixed b/g and HT/non-HT) and how are performance in several scenarios.
 //
@@ -326,7 +327,7 @@ Experiment::Run (Parameters params)
       clientApps.Stop (Seconds (simulationTime + 1));
 
       Simulator::Stop (Seconds (simulationTime + 1));
-      Simulator::Run ();
+      RunMeasured ();
 
       uint64_t totalPacketsThrough = DynamicCast<UdpServer> (serverApp.Get (0))->GetReceived ();
       throughput = totalPacketsThrough * payloadSize * 8 / (simulationTime * 1000000.0);
@@ -371,7 +372,7 @@ Experiment::Run (Parameters params)
       clientApps.Stop (Seconds (simulationTime + 1));
 
       Simulator::Stop (Seconds (simulationTime + 1));
-      Simulator::Run ();
+      RunMeasured ();
 
       uint64_t totalPacketsThrough = DynamicCast<PacketSink> (serverApp.Get (0))->GetTotalRx ();
       throughput += totalPacketsThrough * 8 / (simulationTime * 1000000.0);
@@ -403,12 +404,14 @@ int main (int argc, char *argv[])
   params.simulationTime = 10; //seconds
 
   bool verifyResults = 0; //used for regression
+  bool perfReport = false;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue ("payloadSize", "Payload size in bytes", params.payloadSize);
   cmd.AddValue ("simulationTime", "Simulation time in seconds", params.simulationTime);
   cmd.AddValue ("isUdp", "UDP if set to 1, TCP otherwise", params.isUdp);
   cmd.AddValue ("verifyResults", "Enable/disable results verification at the end of the simulation", verifyResults);
+  cmd.AddValue ("perfReport", "print wall time, events/s and peak RSS", perfReport);
   cmd.Parse (argc, argv);
 
   Experiment experiment;
@@ -670,5 +673,10 @@ int main (int argc, char *argv[])
     }
   std::cout << "Throughput: " << throughput << " Mbit/s \n" << std::endl;
 
+  if (perfReport)
+    {
+      PrintPerfReport ();
+    }
+
   return 0;
 }
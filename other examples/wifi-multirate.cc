@@ -68,6 +68,7 @@
 #include "ns3/ipv4-list-routing-helper.h"
 #include "ns3/rectangle.h"
 #include "ns3/flow-monitor-helper.h"
+#include "perf-report.h"
 
 using namespace ns3;
 
@@ -82,6 +83,10 @@ public:
                         const WifiMacHelper &wifiMac, const YansWifiChannelHelper &wifiChannel, const MobilityHelper &mobility);
 
   bool CommandSetup (int argc, char **argv);
+  bool IsPerfReport ()
+  {
+    return perfReport;
+  }
   bool IsRouting ()
   {
     return (enableRouting == 1) ? 1 : 0;
@@ -138,6 +143,7 @@ private:
   bool enableFlowMon;
   bool enableRouting;
   bool enableMobility;
+  bool perfReport;
 
   NodeContainer containerA, containerB, containerC, containerD;
   std::string rtsThreshold, rateManager, outputFileName;
@@ -165,6 +171,7 @@ Experiment::Experiment (std::string name)
     enableFlowMon (false),
     enableRouting (false),
     enableMobility (false),
+    perfReport (false),
     rtsThreshold ("2200"),
     //0 for enabling rts/cts
     rateManager ("ns3::MinstrelWifiManager"),
@@ -538,7 +545,7 @@ Experiment::Run (const WifiHelper &wifi, const YansWifiPhyHelper &wifiPhy,
     }
 
   Simulator::Stop (Seconds (totalTime));
-  Simulator::Run ();
+  RunMeasured ();
 
   if (enableFlowMon)
     {
@@ -574,6 +581,7 @@ Experiment::CommandSetup (int argc, char **argv)
   cmd.AddValue ("enableRouting", "enable Routing", enableRouting);
   cmd.AddValue ("enableMobility", "enable Mobility", enableMobility);
   cmd.AddValue ("scenario", "scenario ", scenario);
+  cmd.AddValue ("perfReport", "print wall time, events/s and peak RSS", perfReport);
 
   cmd.Parse (argc, argv);
   return true;
@@ -616,5 +624,10 @@ int main (int argc, char *argv[])
   gnuplot.AddDataset (dataset);
   gnuplot.GenerateOutput (outfile);
 
+  if (experiment.IsPerfReport ())
+    {
+      PrintPerfReport ();
+    }
+
   return 0;
 }
@@ -41,6 +41,7 @@
 #include "ns3/yans-wifi-channel.h"
 #include "ns3/multi-model-spectrum-channel.h"
 #include "ns3/propagation-loss-model.h"
+#include "perf-report.h"
 
 // This is a simple example of an IEEE 802.11n Wi-Fi network.
 //
@@ -65,6 +66,7 @@
 //    --wifiType:        select ns3::SpectrumWifiPhy or ns3::YansWifiPhy [ns3::SpectrumWifiPhy]
 //    --errorModelType:  select ns3::NistErrorRateModel or ns3::YansErrorRateModel [ns3::NistErrorRateModel]
 //    --enablePcap:      enable pcap output [false]
+//    --perfReport:      print wall time, events/s and peak RSS [false]
 //
 // By default, the program will step through 64 index values, corresponding
 // to the following MCS, channel width, and guard interval combinations:
@@ -104,6 +106,7 @@ int main (int argc, char *argv[])
   std::string wifiType = "ns3::SpectrumWifiPhy";
   std::string errorModelType = "ns3::NistErrorRateModel";
   bool enablePcap = false;
+  bool perfReport = false;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue ("simulationTime", "Simulation time in seconds", simulationTime);
@@ -112,6 +115,7 @@ int main (int argc, char *argv[])
   cmd.AddValue ("wifiType", "select ns3::SpectrumWifiPhy or ns3::YansWifiPhy", wifiType);
   cmd.AddValue ("errorModelType", "select ns3::NistErrorRateModel or ns3::YansErrorRateModel", errorModelType);
   cmd.AddValue ("enablePcap", "enable pcap output", enablePcap);
+  cmd.AddValue ("perfReport", "print wall time, events/s and peak RSS", perfReport);
   cmd.Parse (argc,argv);
 
   uint16_t startIndex = 0;
@@ -653,7 +657,7 @@ int main (int argc, char *argv[])
         }
 
       Simulator::Stop (Seconds (simulationTime + 1));
-      Simulator::Run ();
+      RunMeasured ();
 
       double throughput;
       uint64_t totalPacketsThrough;
@@ -668,5 +672,9 @@ int main (int argc, char *argv[])
         std::endl;
       Simulator::Destroy ();
     }
+  if (perfReport)
+    {
+      PrintPerfReport ();
+    }
   return 0;
 }